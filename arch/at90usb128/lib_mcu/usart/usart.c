@@ -5,8 +5,11 @@
 
 /* Includes */
 #include <stdbool.h>
+#include <string.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
 #include "config.h"
 #include "usart.h"
 
@@ -19,16 +22,86 @@
 #if ( USART_TX_BUFFER_SIZE & USART_TX_BUFFER_MASK )
 #error TX buffer size is not a power of 2
 #endif
+#if ( USART_RX_BUFFER_SIZE > 32768 )
+#error RX buffer size exceeds 32768 bytes
+#endif
+
+#ifndef USART_STOP_BITS
+#define USART_STOP_BITS 2
+#endif
+
+#ifndef USART_RX_OVERFLOW
+#define USART_RX_OVERFLOW USART_RX_DROP_NEWEST
+#endif
+
+/* Receive buffer indices, 16-bit for buffers larger than 256 bytes */
+#if ( USART_RX_BUFFER_SIZE > 256 )
+typedef unsigned int usart_rx_index_t;
+#else
+typedef unsigned char usart_rx_index_t;
+#endif
+
+/* Access to the receive indices that the interrupt may change meanwhile:
+ * 16-bit indices, the tail moved by USART_RX_DROP_OLDEST, or the RTS line */
+#if ( USART_RX_BUFFER_SIZE > 256 ) || ( USART_RX_OVERFLOW != USART_RX_DROP_NEWEST )
+#define USART_RX_ATOMIC ATOMIC_BLOCK( ATOMIC_RESTORESTATE )
+#else
+#define USART_RX_ATOMIC
+#endif
+
+/* RTS line, high to stop the sender */
+#if ( USART_RX_OVERFLOW == USART_RX_FLOW_CONTROL )
+#if ( USART_RTS_HIGH >= USART_RX_BUFFER_SIZE ) || ( USART_RTS_LOW >= USART_RTS_HIGH )
+#error RTS watermarks must satisfy USART_RTS_LOW < USART_RTS_HIGH < USART_RX_BUFFER_SIZE
+#endif
+#define Usart_rts_init()  ( USART_RTS_DDR |= ( 1 << USART_RTS_BIT ) )
+#define Usart_rts_stop()  ( USART_RTS_PORT |= ( 1 << USART_RTS_BIT ) )
+#define Usart_rts_go()    ( USART_RTS_PORT &= ~( 1 << USART_RTS_BIT ) )
+#endif
+
+/* CTS line, high when the peer cannot receive, interrupting on any edge */
+#if ( USART_TX_FLOW_CONTROL == true )
+#define Usart_cts_init()  ( EICRA = ( EICRA & ~( 3 << ( 2 * USART_CTS_INT ) ) ) | ( 1 << ( 2 * USART_CTS_INT ) ), \
+                            EIMSK |= ( 1 << USART_CTS_INT ) )
+#define Is_usart_cts_stop() ( USART_CTS_PIN & ( 1 << USART_CTS_BIT ) )
+#endif
 
 /* Static Variables */
 static unsigned char USART_RxBuf[USART_RX_BUFFER_SIZE];
-static volatile unsigned char USART_RxHead;
-static volatile unsigned char USART_RxTail;
+static volatile usart_rx_index_t USART_RxHead;
+static volatile usart_rx_index_t USART_RxTail;
+static usart_rx_index_t USART_RxPeekTail;
 static unsigned char USART_TxBuf[USART_TX_BUFFER_SIZE];
 static volatile unsigned char USART_TxHead;
 static volatile unsigned char USART_TxTail;
+static unsigned char USART_TxPending;
+static volatile uint32_t USART_RxOverflows;
+static volatile usart_rx_index_t USART_RxHighWater;
+static volatile bool USART_TxBusy;
 
-bool USART0_CTS( void )
+/* UBRR values of the USART_BAUD_xxx rates, double speed for the finest divider */
+static const unsigned int USART_BaudTable[USART_BAUD_COUNT] PROGMEM =
+{
+    USART_UBRR_2X( 9600 ) | USART_U2X,
+    USART_UBRR_2X( 19200 ) | USART_U2X,
+    USART_UBRR_2X( 38400 ) | USART_U2X,
+    USART_UBRR_2X( 57600 ) | USART_U2X,
+    USART_UBRR_2X( 76800 ) | USART_U2X,
+    USART_UBRR_2X( 250000 ) | USART_U2X,
+    USART_UBRR_2X( 500000 ) | USART_U2X,
+    USART_UBRR_2X( 1000000 ) | USART_U2X
+};
+
+#if ( USART_RX_OVERFLOW == USART_RX_FLOW_CONTROL )
+/* Let the sender go on once the buffer is down to the low watermark */
+static inline void USART_RxFlow( usart_rx_index_t tmptail )
+{
+    if( ( ( USART_RxHead - tmptail ) & USART_RX_BUFFER_MASK ) <= USART_RTS_LOW )
+        Usart_rts_go();
+}
+#endif
+
+bool USART0_TxRoom( void )
 {
     unsigned char tmphead;
 
@@ -36,7 +109,7 @@ bool USART0_CTS( void )
     tmphead = ( USART_TxHead + 1 ) & USART_TX_BUFFER_MASK;
 
     /* Return 0 (false) if the transmit buffer is full */
-    return ( tmphead == USART_TxTail );
+    return ( tmphead != USART_TxTail );
 }
 
 void USART0_Init( unsigned int baudrate )
@@ -44,15 +117,18 @@ void USART0_Init( unsigned int baudrate )
     unsigned char x;
 
     /* Set the baud rate */
-    UBRR1H = ( unsigned char )( baudrate >> 8 );
-    UBRR1L = ( unsigned char )baudrate;
+    USART0_SetBaud( baudrate );
 
     /* Enable UART receiver and transmitter */
     UCSR1B = ( ( 1 << RXCIE1 ) | ( 1 << RXEN1 ) | ( 1 << TXEN1 ) );
 
-    /* Set frame format: 8 data 2stop */
+    /* Set frame format: 8 data, USART_STOP_BITS stop */
     //For devices with Extended IO
+#if ( USART_STOP_BITS == 2 )
     UCSR1C = ( 1 << USBS1 ) | ( 1 << UCSZ11 ) | ( 1 << UCSZ10 );
+#else
+    UCSR1C = ( 1 << UCSZ11 ) | ( 1 << UCSZ10 );
+#endif
 
     //For devices without Extended IO
     //UCSR0C = (1<<URSEL)|(1<<USBS0)|(1<<UCSZ01)|(1<<UCSZ00);
@@ -64,6 +140,17 @@ void USART0_Init( unsigned int baudrate )
     USART_RxHead = x;
     USART_TxTail = x;
     USART_TxHead = x;
+    USART_RxOverflows = x;
+    USART_RxHighWater = x;
+    USART_TxBusy = false;
+
+#if ( USART_RX_OVERFLOW == USART_RX_FLOW_CONTROL )
+    Usart_rts_go();
+    Usart_rts_init();
+#endif
+#if ( USART_TX_FLOW_CONTROL == true )
+    Usart_cts_init();
+#endif
 }
 
 /**
@@ -72,30 +159,71 @@ void USART0_Init( unsigned int baudrate )
 ISR(USART1_RX_vect)
 {
     unsigned char rxdata;
-    unsigned char tmphead;
+#ifndef Usart_rx_action
+    usart_rx_index_t tmphead;
+#endif
 
     /* Read the received data */
     rxdata = UDR1;
 
+#ifdef Usart_rx_action
+    /* Hand the data over instead of buffering it */
+    Usart_rx_action( rxdata );
+#else
     /* Calculate buffer index */
     tmphead = ( USART_RxHead + 1 ) & USART_RX_BUFFER_MASK;
 
-    /* Store new index */
-    USART_RxHead = tmphead;
-
     if( tmphead == USART_RxTail )
     {
-        /* ERROR! Receive buffer overflow */
+        /* Receive buffer overflow: one byte is lost */
+        ++USART_RxOverflows;
+#if ( USART_RX_OVERFLOW == USART_RX_DROP_OLDEST )
+        USART_RxTail = ( USART_RxTail + 1 ) & USART_RX_BUFFER_MASK;
+#else
+        return;
+#endif
     }
 
     /* Store received data in buffer */
     USART_RxBuf[tmphead] = rxdata;
+
+    /* Store new index */
+    USART_RxHead = tmphead;
+
+    /* Record the highest buffer usage */
+    tmphead = ( tmphead - USART_RxTail ) & USART_RX_BUFFER_MASK;
+    if( tmphead > USART_RxHighWater )
+        USART_RxHighWater = tmphead;
+
+#if ( USART_RX_OVERFLOW == USART_RX_FLOW_CONTROL )
+    /* Stop the sender at the high watermark */
+    if( tmphead >= USART_RTS_HIGH )
+        Usart_rts_stop();
+#endif
+#endif
+
+#ifdef Usart_rx_event
+    /* Tell the application data has arrived */
+    Usart_rx_event();
+#endif
 }
 
-ISR(USART1_TX_vect)
+/**
+ * Interrupt handler called when USART1 can take the next byte to transmit
+ */
+ISR(USART1_UDRE_vect)
 {
     unsigned char tmptail;
 
+#if ( USART_TX_FLOW_CONTROL == true )
+    if( Is_usart_cts_stop() )
+    {
+        /* Disable UDRE interrupt until the CTS interrupt lets us go on */
+        UCSR1B &= ~( 1 << UDRIE1 );
+        return;
+    }
+#endif
+
     /* Check if all data is transmitted */
     if( USART_TxHead != USART_TxTail )
     {
@@ -105,38 +233,204 @@ ISR(USART1_TX_vect)
         /* Store new index */
         USART_TxTail = tmptail;
 
-        /* Start transmition */
+        /* Start transmition, TXC1 now only tells the buffer has drained */
+        UCSR1A |= ( 1 << TXC1 );
         UDR1 = USART_TxBuf[tmptail];
+        USART_TxBusy = true;
     }
     else
     {
         /* Disable UDRE interrupt */
         UCSR1B &= ~( 1 << UDRIE1 );
+
+        /* Wait for the last byte to leave the shift register */
+        UCSR1B |= ( 1 << TXCIE1 );
+    }
+}
+
+/**
+ * Interrupt handler called when USART1 has shifted out its last byte
+ */
+ISR(USART1_TX_vect)
+{
+    /* Disable TXC interrupt */
+    UCSR1B &= ~( 1 << TXCIE1 );
+
+    /* More data may have been queued since the UDRE interrupt gave up */
+    if( USART_TxHead == USART_TxTail )
+    {
+        USART_TxBusy = false;
+#ifdef Usart_tx_done_action
+        Usart_tx_done_action();
+#endif
     }
 }
 
+#if ( USART_TX_FLOW_CONTROL == true )
+/**
+ * Interrupt handler called when the CTS line changes
+ */
+ISR(USART_CTS_vect)
+{
+    /* Resume transmission if the peer is ready and data is waiting */
+    if( !Is_usart_cts_stop() && ( USART_TxHead != USART_TxTail ) )
+    {
+        UCSR1B |= ( 1 << UDRIE1 );
+    }
+}
+#endif
+
+void USART0_SetBaud( unsigned int baudrate )
+{
+    /* Select normal or double speed, TXC1 is left alone when written with 0 */
+    UCSR1A = ( baudrate & USART_U2X ) ? ( 1 << U2X1 ) : 0;
+
+    /* Set the divider */
+    UBRR1H = ( unsigned char )( ( baudrate >> 8 ) & 0x0F );
+    UBRR1L = ( unsigned char )baudrate;
+}
+
+unsigned int USART0_BaudUbrr( unsigned char code )
+{
+    return pgm_read_word( &USART_BaudTable[code] );
+}
+
+bool USART0_TxIdle( void )
+{
+    /* Return 0 (false) while bytes are buffered or being shifted out */
+    return ( !USART_TxBusy && ( USART_TxHead == USART_TxTail ) );
+}
+
 unsigned char USART0_Receive( void )
 {
-    unsigned char tmptail;
+    usart_rx_index_t tmptail;
+    unsigned char rxdata;
 
     /* Wait for incomming data */
-    while( USART_RxHead == USART_RxTail )
+    while( !USART0_RTR() )
         ;
 
-    /* Calculate buffer index */
-    tmptail = ( USART_RxTail + 1 ) & USART_RX_BUFFER_MASK;
+    USART_RX_ATOMIC
+    {
+        /* Calculate buffer index */
+        tmptail = ( USART_RxTail + 1 ) & USART_RX_BUFFER_MASK;
 
-    /* Store new index */
-    USART_RxTail = tmptail;
+        /* Read data before its slot can be reused */
+        rxdata = USART_RxBuf[tmptail];
+
+        /* Store new index */
+        USART_RxTail = tmptail;
+
+#if ( USART_RX_OVERFLOW == USART_RX_FLOW_CONTROL )
+        USART_RxFlow( tmptail );
+#endif
+    }
 
     /* Return data */
-    return USART_RxBuf[tmptail];
+    return rxdata;
+}
+
+unsigned int USART0_Read( unsigned char *rxdata, unsigned int n )
+{
+    const unsigned char *span;
+    unsigned int count = 0;
+    unsigned int len;
+
+    while( count < n )
+    {
+        len = USART0_RxPeek( &span );
+        if( 0 == len )
+            break;
+
+        if( len > n - count )
+            len = n - count;
+        memcpy( rxdata + count, span, len );
+        USART0_RxCommit( len );
+        count += len;
+    }
+    return count;
+}
+
+unsigned int USART0_RxPeek( const unsigned char **span )
+{
+    usart_rx_index_t tmphead;
+    usart_rx_index_t tmptail;
+    unsigned int count;
+
+    USART_RX_ATOMIC
+    {
+        tmphead = USART_RxHead;
+        tmptail = USART_RxTail;
+    }
+    USART_RxPeekTail = tmptail;
+
+    /* Received bytes follow the tail, up to the end of the buffer */
+    count = ( tmphead - tmptail ) & USART_RX_BUFFER_MASK;
+    tmptail = ( tmptail + 1 ) & USART_RX_BUFFER_MASK;
+    if( count > ( unsigned int )( USART_RX_BUFFER_SIZE - tmptail ) )
+        count = USART_RX_BUFFER_SIZE - tmptail;
+
+    *span = &USART_RxBuf[tmptail];
+    return count;
+}
+
+void USART0_RxCommit( unsigned int n )
+{
+    usart_rx_index_t tmptail;
+#if ( USART_RX_OVERFLOW == USART_RX_DROP_OLDEST )
+    unsigned int dropped;
+#endif
+
+    USART_RX_ATOMIC
+    {
+        tmptail = USART_RxTail;
+#if ( USART_RX_OVERFLOW == USART_RX_DROP_OLDEST )
+        /* Bytes dropped by the interrupt since USART0_RxPeek() are gone already */
+        dropped = ( tmptail - USART_RxPeekTail ) & USART_RX_BUFFER_MASK;
+        n = ( n > dropped ) ? ( n - dropped ) : 0;
+#endif
+        /* Store new index */
+        tmptail = ( tmptail + n ) & USART_RX_BUFFER_MASK;
+        USART_RxTail = tmptail;
+
+#if ( USART_RX_OVERFLOW == USART_RX_FLOW_CONTROL )
+        USART_RxFlow( tmptail );
+#endif
+    }
+}
+
+uint32_t USART0_RxOverflows( void )
+{
+    uint32_t overflows;
+
+    ATOMIC_BLOCK( ATOMIC_RESTORESTATE )
+    {
+        overflows = USART_RxOverflows;
+    }
+    return overflows;
+}
+
+unsigned int USART0_RxHighWater( void )
+{
+    unsigned int high_water;
+
+    ATOMIC_BLOCK( ATOMIC_RESTORESTATE )
+    {
+        high_water = USART_RxHighWater;
+    }
+    return high_water;
 }
 
 bool USART0_RTR( void )
 {
-    /* Return 0 (false) if the receive buffer is empty */
-    return ( USART_RxHead != USART_RxTail );
+    bool ready;
+
+    USART_RX_ATOMIC
+    {
+        /* Return 0 (false) if the receive buffer is empty */
+        ready = ( USART_RxHead != USART_RxTail );
+    }
+    return ready;
 }
 
 void USART0_Transmit( unsigned char txdata )
@@ -159,3 +453,91 @@ void USART0_Transmit( unsigned char txdata )
     /* Enable UDRE interrupt */
     UCSR1B |= ( 1 << UDRIE1 );
 }
+
+unsigned int USART0_Write( const unsigned char *txdata, unsigned int n )
+{
+    unsigned char tmphead;
+    unsigned char room;
+    unsigned int i;
+
+    /* Calculate free room, one slot always stays empty */
+    tmphead = USART_TxHead;
+    room = USART_TX_BUFFER_MASK - ( ( tmphead - USART_TxTail ) & USART_TX_BUFFER_MASK );
+    if( n > room )
+        n = room;
+
+    /* Store data in buffer */
+    for( i = 0; i < n; ++i )
+    {
+        tmphead = ( tmphead + 1 ) & USART_TX_BUFFER_MASK;
+        USART_TxBuf[tmphead] = txdata[i];
+    }
+
+    if( 0 != n )
+    {
+        /* Store new index */
+        USART_TxHead = tmphead;
+
+        /* Enable UDRE interrupt */
+        UCSR1B |= ( 1 << UDRIE1 );
+    }
+    return n;
+}
+
+bool USART0_TxReserve( unsigned char n )
+{
+    unsigned char used;
+
+    /* Calculate buffer usage */
+    used = ( USART_TxHead - USART_TxTail ) & USART_TX_BUFFER_MASK;
+
+    /* One slot always stays empty to tell a full buffer from an empty one */
+    if( n > ( USART_TX_BUFFER_MASK - used ) )
+        return false;
+
+    USART_TxPending = USART_TxHead;
+    return true;
+}
+
+void USART0_TxPut( unsigned char txdata )
+{
+    unsigned char tmphead;
+
+    /* Calculate buffer index */
+    tmphead = ( USART_TxPending + 1 ) & USART_TX_BUFFER_MASK;
+
+    /* Store data in buffer, room was checked by USART0_TxReserve() */
+    USART_TxBuf[tmphead] = txdata;
+
+    /* Store new pending index */
+    USART_TxPending = tmphead;
+}
+
+void USART0_TxRepeat( unsigned char copies )
+{
+    unsigned char n;
+    unsigned char i;
+    unsigned char src;
+
+    /* The block stored so far follows the last committed byte */
+    n = ( USART_TxPending - USART_TxHead ) & USART_TX_BUFFER_MASK;
+
+    while( copies-- )
+    {
+        src = USART_TxHead;
+        for( i = 0; i < n; ++i )
+        {
+            src = ( src + 1 ) & USART_TX_BUFFER_MASK;
+            USART0_TxPut( USART_TxBuf[src] );
+        }
+    }
+}
+
+void USART0_TxCommit( void )
+{
+    /* Store new index */
+    USART_TxHead = USART_TxPending;
+
+    /* Enable UDRE interrupt */
+    UCSR1B |= ( 1 << UDRIE1 );
+}
@@ -14,30 +14,116 @@
 //_____ I N C L U D E S ________________________________________________________
 
 #include <stdbool.h>
+#include <stdint.h>
 
 //_____ M A C R O S ____________________________________________________________
 
+/**
+ * UBRR value for a baud rate in normal speed mode, rounded to the nearest divider.
+ * FOSC is the CPU frequency in kHz.
+ */
+#define USART_UBRR( baud )  ( ( ( ( FOSC * 1000UL ) + ( 8UL * ( baud ) ) ) / ( 16UL * ( baud ) ) ) - 1 )
+
+/**
+ * UBRR value for a baud rate in double speed mode, to be combined with USART_U2X.
+ */
+#define USART_UBRR_2X( baud )   ( ( ( ( FOSC * 1000UL ) + ( 4UL * ( baud ) ) ) / ( 8UL * ( baud ) ) ) - 1 )
+
+/**
+ * Flag of a baud rate argument selecting double speed mode (U2X).
+ */
+#define USART_U2X               0x8000
+
+/**
+ * Baud rate codes of USART0_BaudUbrr(). At FOSC 8000, every rate is within
+ * 2.1% (57600) and the rates from 250000 up are exact.
+ */
+#define USART_BAUD_9600         0
+#define USART_BAUD_19200        1
+#define USART_BAUD_38400        2
+#define USART_BAUD_57600        3
+#define USART_BAUD_76800        4
+#define USART_BAUD_250K         5
+#define USART_BAUD_500K         6
+#define USART_BAUD_1M           7
+#define USART_BAUD_COUNT        8
+
+/**
+ * Receive buffer overflow policies, selected by USART_RX_OVERFLOW
+ */
+#define USART_RX_DROP_NEWEST    0   ///< drop the received byte
+#define USART_RX_DROP_OLDEST    1   ///< drop the oldest buffered byte
+#define USART_RX_FLOW_CONTROL   2   ///< drop the received byte, stop the sender with RTS
+
 //_____ D E C L A R A T I O N __________________________________________________
 
 /**
  * Initialize USART0 hardware, buffers and interrupt handlers.
  *
- * @param baudrate target bit clock for USART, already in proper format for UBRR
+ * @param baudrate target bit clock for USART, already in proper format for UBRR,
+ * with USART_U2X for double speed mode
  */
 void USART0_Init( unsigned int baudrate );
 
+/**
+ * Change the baud rate, without touching the buffers.
+ * Bytes being shifted in or out meanwhile are garbled, see USART0_TxIdle().
+ *
+ * @param baudrate UBRR value, with USART_U2X for double speed mode
+ */
+void USART0_SetBaud( unsigned int baudrate );
+
+/**
+ * Look up the baud rate argument for a rate code.
+ * @param code USART_BAUD_xxx
+ * @return UBRR value, with USART_U2X for double speed mode
+ */
+unsigned int USART0_BaudUbrr( unsigned char code );
+
 /**
  * Read a byte from the data buffer. Blocks if no bytes are available.
  * @return next received byte
  */
 unsigned char USART0_Receive( void );
 
+/**
+ * Read up to n bytes from the data buffer, without waiting.
+ * @param rxdata destination of the bytes
+ * @param n maximum number of bytes to read
+ * @return number of bytes read
+ */
+unsigned int USART0_Read( unsigned char *rxdata, unsigned int n );
+
+/**
+ * Get the received bytes stored contiguously in the data buffer, without
+ * removing them. The bytes are removed by USART0_RxCommit(). Further bytes may
+ * follow at the start of the buffer: peek again after the commit.
+ * With USART_RX_DROP_OLDEST, an overflow may overwrite the span meanwhile.
+ * @param span set to the first received byte
+ * @return number of bytes at span, 0 if the buffer is empty
+ */
+unsigned int USART0_RxPeek( const unsigned char **span );
+
+/**
+ * Remove bytes obtained with USART0_RxPeek() from the data buffer.
+ * @param n number of bytes to remove, at most the span returned by USART0_RxPeek()
+ */
+void USART0_RxCommit( unsigned int n );
+
 /**
  * Add a byte to the data buffer to be transmitted. Blocks if no space is available.
  * @param txdata
  */
 void USART0_Transmit( unsigned char txdata );
 
+/**
+ * Add up to n bytes to the data buffer to be transmitted, without waiting.
+ * @param txdata bytes to transmit
+ * @param n number of bytes to transmit
+ * @return number of bytes added
+ */
+unsigned int USART0_Write( const unsigned char *txdata, unsigned int n );
+
 /**
  * Indicates USART0 is Ready-To-Read i.e. there is data in the receive buffer
  * @return
@@ -45,7 +131,54 @@ void USART0_Transmit( unsigned char txdata );
 bool USART0_RTR( void );
 
 /**
- * Indicates USART0 is Clear-To-Send i.e. there is empty room in transmit buffer
+ * Number of bytes received while the receive buffer was full.
+ * @return overflow count since USART0_Init()
+ */
+uint32_t USART0_RxOverflows( void );
+
+/**
+ * Highest number of bytes waiting in the receive buffer.
+ * @return high-water mark since USART0_Init()
+ */
+unsigned int USART0_RxHighWater( void );
+
+/**
+ * Indicates there is empty room in the transmit buffer.
+ * The peer's CTS line is not considered: with USART_TX_FLOW_CONTROL, buffered
+ * bytes simply wait for it.
+ * Formerly USART0_CTS(), which returned true when the buffer was full.
+ * @return
+ */
+bool USART0_TxRoom( void );
+
+/**
+ * Indicates USART0 has sent every byte, the last one included, and the line is idle
  * @return
  */
-bool USART0_CTS( void );
+bool USART0_TxIdle( void );
+
+/**
+ * Reserve room for a block of bytes in the transmit buffer, without waiting.
+ * The block is written with USART0_TxPut() and sent once USART0_TxCommit() is called.
+ * @param n number of bytes to reserve
+ * @return false if the transmit buffer does not have room for n bytes
+ */
+bool USART0_TxReserve( unsigned char n );
+
+/**
+ * Store a byte of the reserved block in the transmit buffer.
+ * @param txdata
+ */
+void USART0_TxPut( unsigned char txdata );
+
+/**
+ * Store copies of the bytes stored since USART0_TxReserve() after them.
+ * Room for every copy must have been reserved.
+ * @param copies number of copies to add
+ */
+void USART0_TxRepeat( unsigned char copies );
+
+/**
+ * Start transmitting the bytes stored since USART0_TxReserve().
+ */
+void USART0_TxCommit( void );
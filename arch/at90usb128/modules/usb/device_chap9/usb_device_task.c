@@ -134,6 +134,8 @@ void usb_device_task_init( void )
 #if (USB_LOW_SPEED_DEVICE==true)
     Usb_low_speed_mode();
 #endif
+    // VBUS changes wake usb_device_task() up, see Usb_vbus_change_action()
+    Usb_enable_vbus_interrupt();
     sei();
 #if (USB_OTG_FEATURE == true)
     Usb_enable_id_interrupt();
@@ -165,6 +167,9 @@ void usb_start_device( void )
 
     Usb_enable_suspend_interrupt();
     Usb_enable_reset_interrupt();
+    // Start of frame drives the HID report, the timed events and the FRAME
+    // counter, see sof_action()
+    Usb_enable_sof_interrupt();
 #if (USB_OTG_FEATURE == true)
     Usb_enable_id_interrupt();
 #endif
@@ -458,4 +463,7 @@ void usb_device_task( void )
         {
         usb_process_request();
         }
+    // The next SETUP packet wakes this task up, see Usb_endpoint_action()
+    Usb_select_endpoint(EP_CONTROL);
+    Usb_enable_receive_setup_interrupt();
     }
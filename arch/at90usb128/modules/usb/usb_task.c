@@ -336,6 +336,12 @@ ISR(USB_GEN_vect)
     // ---------- DEVICE events management -----------------------------------
 #if (USB_DEVICE_FEATURE == true)
 
+    // - VBUS transition: usb_device_task() attaches or detaches the device
+    if( Is_usb_vbus_transition() && Is_usb_vbus_interrupt_enabled() )
+        {
+        Usb_ack_vbus_transition();
+        Usb_vbus_change_action();
+        }
     // - Device start of frame received
     if( Is_usb_sof() && Is_sof_interrupt_enabled() )
         {
@@ -610,4 +616,32 @@ void usb_delay_ms(uint8_t ms)
         }
     }
 #endif
+
+/**
+ * @brief USB endpoint interrupt subroutine
+ *
+ * Runs when an endpoint with its interrupts enabled has received a SETUP or
+ * OUT packet. The interrupts of the endpoint are disabled until the task
+ * serving it enables them again, and Usb_endpoint_action() wakes that task up.
+ */
+ISR(USB_COM_vect)
+    {
+    uint8_t save_ep;
+    uint8_t flags;
+    uint8_t ep;
+
+    save_ep = Usb_get_selected_endpoint();
+    flags = Usb_interrupt_flags();
+    for( ep = 0; flags; ++ep, flags >>= 1 )
+        {
+        if( flags & 1 )
+            {
+            Usb_select_endpoint(ep);
+            Usb_disable_receive_setup_interrupt();
+            Usb_disable_receive_out_interrupt();
+            Usb_endpoint_action(ep);
+            }
+        }
+    Usb_select_endpoint(save_ep);
+    }
 #endif // USB_DEVICE_FEATURE == true
@@ -6,6 +6,10 @@
  * Configuration:
  * - SCHEDULER_TYPE in scheduler.h header file
  * - Task & init for at least task number 1 must be defined
+ * - With SCHEDULER_EVENT, Scheduler_task_x_priority for every task, 0 (highest) to 7
+ * - SCHEDULER_PROFILE to time the task calls with timer 1
+ * - SCHEDULER_SLEEP to sleep while no event is pending, timing the wake-ups
+ *   with timer 1
  *
  * - Compiler:           IAR EWAVR and GNU GCC for AVR
  * - Supported devices:  AT90USB1287, AT90USB1286, AT90USB647, AT90USB646
@@ -47,14 +51,52 @@
 #include "config.h"                         // system definition
 #include "conf/conf_scheduler.h"            // Configuration for the scheduler
 #include "scheduler.h"                      // scheduler definition
+#if SCHEDULER_PROFILING == true
+#include <string.h>
+#endif
+#if SCHEDULER_SLEEP == true
+#include <avr/interrupt.h>
+#include "lib_mcu/power/power_drv.h"
+#endif
 
 //_____ M A C R O S ____________________________________________________________
 //_____ D E F I N I T I O N ____________________________________________________
-#if SCHEDULER_TYPE != SCHEDULER_FREE
+#if (SCHEDULER_TYPE != SCHEDULER_FREE) && (SCHEDULER_TYPE != SCHEDULER_EVENT)
  * When SCHEDULER_TYPE != SCHEDULER_FREE, this flag control task calls.
 bit scheduler_tick_flag;
 #endif
 
+/**
+ * Events posted to the tasks, all of them set at start-up so that every task
+ * runs once.
+ */
+volatile uint8_t scheduler_events;
+
+#if SCHEDULER_PROFILING == true
+/**
+ * Profile of a task, see scheduler_profile_value()
+ */
+struct scheduler_profile
+{
+	uint32_t calls;                 ///< Number of calls
+	uint32_t samples;               ///< Calls summed in total, halved with it
+	uint32_t total;                 ///< Ticks spent in the calls
+	uint16_t min;                   ///< Shortest call
+	uint16_t max;                   ///< Longest call
+	uint32_t bins[SCHEDULER_PROFILE_BINS];
+};
+
+/// Task profiles, indexed by priority, then the wake-up latency and the user profiles
+static struct scheduler_profile scheduler_profile[SCHEDULER_PROFILES];
+#endif
+
+#if SCHEDULER_SLEEP == true
+/// Timer 1 at the end of the last sleep
+static uint16_t scheduler_wake;
+/// Woken up and no task run since
+static bool scheduler_woken;
+#endif
+
 #ifdef TOKEN_MODE
  * Can be used to avoid that some tasks executes at same time.
  * The tasks check if the token is free before executing.
@@ -125,18 +167,251 @@ void scheduler_init(void)
 	Scheduler_call_next_init();
 #endif
 	Scheduler_reset_tick_flag();
+#if SCHEDULER_TYPE == SCHEDULER_EVENT
+	scheduler_events = SCHEDULER_EVENTS;
+#endif
+#if SCHEDULER_PROFILING == true
+	scheduler_profile_clear();
+	TCCR1A = 0;
+	TCCR1B = SCHEDULER_PROFILE_CLOCK;
+#endif
+}
+
+#if SCHEDULER_TYPE == SCHEDULER_EVENT
+/**
+ * Tasks indexed by priority, which is also the bit of their event
+ */
+static void (* const scheduler_table[8])(void) =
+{
+#ifdef Scheduler_task_1
+	[Scheduler_task_1_priority] = Scheduler_task_1,
+#endif
+#ifdef Scheduler_task_2
+	[Scheduler_task_2_priority] = Scheduler_task_2,
+#endif
+#ifdef Scheduler_task_3
+	[Scheduler_task_3_priority] = Scheduler_task_3,
+#endif
+#ifdef Scheduler_task_4
+	[Scheduler_task_4_priority] = Scheduler_task_4,
+#endif
+#ifdef Scheduler_task_5
+	[Scheduler_task_5_priority] = Scheduler_task_5,
+#endif
+#ifdef Scheduler_task_6
+	[Scheduler_task_6_priority] = Scheduler_task_6,
+#endif
+#ifdef Scheduler_task_7
+	[Scheduler_task_7_priority] = Scheduler_task_7,
+#endif
+#ifdef Scheduler_task_8
+	[Scheduler_task_8_priority] = Scheduler_task_8,
+#endif
+#ifdef Scheduler_task_9
+	[Scheduler_task_9_priority] = Scheduler_task_9,
+#endif
+#ifdef Scheduler_task_10
+	[Scheduler_task_10_priority] = Scheduler_task_10,
+#endif
+#ifdef Scheduler_task_11
+	[Scheduler_task_11_priority] = Scheduler_task_11,
+#endif
+};
+
+#endif
+
+#if SCHEDULER_PROFILING == true
+/**
+ * @brief Add a duration to a profile
+ *
+ * @param p         profile
+ * @param ticks     duration
+ */
+static void scheduler_profile_add(struct scheduler_profile *p, uint16_t ticks)
+{
+	uint8_t bin;
+
+	if (p->total > UINT32_MAX - ticks)
+	{
+		// Keep the mean
+		p->total >>= 1;
+		p->samples >>= 1;
+	}
+	p->total += ticks;
+	++p->samples;
+	if (0 == p->calls++ || ticks < p->min)
+		p->min = ticks;
+	if (ticks > p->max)
+		p->max = ticks;
+	for (bin = 0; bin < SCHEDULER_PROFILE_BINS - 1; ++bin)
+	{
+		ticks >>= 2;
+		if (0 == ticks)
+			break;
+	}
+	++p->bins[bin];
 }
 
+#if SCHEDULER_SLEEP == true
+/**
+ * @brief Add the wake-up latency to its profile, before the first task called
+ * since the last sleep
+ */
+static inline void scheduler_profile_wake(void)
+{
+	if (scheduler_woken)
+	{
+		scheduler_woken = false;
+		scheduler_profile_add(&scheduler_profile[SCHEDULER_PROFILE_WAKE], TCNT1 - scheduler_wake);
+	}
+}
+#endif
+
+#if SCHEDULER_PROFILE == true
+/**
+ * @brief Call a task and add the duration of the call to its profile
+ *
+ * The duration includes the few cycles taken to read the timer. A call
+ * longer than the timer period is recorded as 0xFFFF ticks.
+ *
+ * @param i     task priority
+ */
+static void scheduler_profile_call(uint8_t i)
+{
+	uint16_t start;
+	uint16_t end;
+	uint16_t ticks;
+
+	TIFR1 = (1 << TOV1);
+	start = TCNT1;
+	scheduler_table[i]();
+	end = TCNT1;
+	ticks = end - start;
+	// The timer wrapped and went past the start again
+	if ((TIFR1 & (1 << TOV1)) && (end >= start))
+		ticks = 0xFFFF;
+	scheduler_profile_add(&scheduler_profile[i], ticks);
+}
+#endif
+
+/**
+ * @brief Read a value of the task profiles
+ *
+ * @param index     SCHEDULER_PROFILE_VALUES * profile + SCHEDULER_PROFILE_xxx,
+ *                  below SCHEDULER_PROFILE_COUNT, the profile being the task
+ *                  priority, SCHEDULER_PROFILE_WAKE or a user profile
+ *
+ * @return the value, 0 for a priority without a task
+ */
+uint32_t scheduler_profile_value(uint8_t index)
+{
+	const struct scheduler_profile *p = &scheduler_profile[index / SCHEDULER_PROFILE_VALUES];
+
+	index %= SCHEDULER_PROFILE_VALUES;
+	switch (index)
+	{
+	case SCHEDULER_PROFILE_CALLS:
+		return p->calls;
+	case SCHEDULER_PROFILE_MEAN:
+		return p->samples ? p->total / p->samples : 0;
+	case SCHEDULER_PROFILE_MIN:
+		return p->min;
+	case SCHEDULER_PROFILE_MAX:
+		return p->max;
+	default:
+		return p->bins[index - SCHEDULER_PROFILE_BIN];
+	}
+}
+
+/**
+ * @brief Add a duration to a user profile, from a task
+ *
+ * @param profile   SCHEDULER_PROFILE_FIRST_USER onwards
+ * @param ticks     duration, in ticks of SCHEDULER_PROFILE_CLOCK
+ */
+void scheduler_profile_record(uint8_t profile, uint16_t ticks)
+{
+	scheduler_profile_add(&scheduler_profile[profile], ticks);
+}
+
+/**
+ * @brief Clear the task profiles
+ */
+void scheduler_profile_clear(void)
+{
+	memset(scheduler_profile, 0, sizeof(scheduler_profile));
+}
+#endif
+
+#if SCHEDULER_SLEEP == true
+/**
+ * @brief Sleep until an interrupt, called with the interrupts disabled
+ *
+ * Idle is the deepest sleep mode keeping the USART receiver, the USB
+ * controller and the timers clocked. The interrupts are enabled by the
+ * instruction just before SLEEP, so that an event posted since the scheduler
+ * found none can only be posted by an interrupt waking it up.
+ */
+static inline void scheduler_sleep(void)
+{
+	Setup_idle_mode();
+	sei();
+	Sleep_instruction();
+	SMCR = 0;
+	scheduler_wake = TCNT1;
+	scheduler_woken = true;
+}
+#endif
+
 /**
  * @brief Task execution scheduler
  *
+ * With SCHEDULER_EVENT, a task only runs once its event has been posted, and
+ * after each task the pending event of highest priority (lowest bit) is
+ * served first. Its task is looked up in scheduler_table. The event is taken
+ * before the call, so that an event posted while the task runs makes it run
+ * again. With SCHEDULER_SLEEP, the CPU sleeps while no event is pending.
+ *
  * @warning Code:XX bytes (function code length)
  */
 void scheduler_tasks(void)
 {
+#if SCHEDULER_TYPE == SCHEDULER_EVENT
+	uint8_t event;
+	uint8_t i;
+#endif
+
 	// To avoid uncalled segment warning if the empty function is not used
 	scheduler_empty_fct();
 
+#if SCHEDULER_TYPE == SCHEDULER_EVENT
+	for (;;)
+	{
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			// Lowest bit set
+			event = scheduler_events & (uint8_t)-scheduler_events;
+			scheduler_events &= ~event;
+#if SCHEDULER_SLEEP == true
+			if (0 == event)
+				scheduler_sleep();
+#endif
+		}
+		if (0 == event)
+			continue;
+
+		for (i = 0; !(event & 1); ++i)
+			event >>= 1;
+#if SCHEDULER_SLEEP == true
+		scheduler_profile_wake();
+#endif
+#if SCHEDULER_PROFILE == true
+		scheduler_profile_call(i);
+#else
+		scheduler_table[i]();
+#endif
+	}
+#else
 	for (;;)
 	{
 		Scheduler_new_schedule();
@@ -185,6 +460,7 @@ void scheduler_tasks(void)
 		Scheduler_call_next_task();
 #endif
 	}
+#endif
 }
 
 /**
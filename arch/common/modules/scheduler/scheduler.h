@@ -47,6 +47,9 @@
 #define _SCHEDULER_H_
 
 //_____ I N C L U D E S ________________________________________________________
+#include <stdbool.h>
+#include <stdint.h>
+#include <util/atomic.h>
 #ifdef KEIL
 #include <intrins.h>
 #define Wait_semaphore(a) while(!_testbit_(a))
@@ -80,6 +83,7 @@
 #define SCHEDULER_TIMED       1
 #define SCHEDULER_TASK        2
 #define SCHEDULER_FREE        3
+#define SCHEDULER_EVENT       4
 
 #ifdef Scheduler_time_init
 extern void Scheduler_time_init (void);
@@ -161,11 +165,238 @@ extern void Scheduler_task_10 (void);
 extern void Scheduler_task_11 (void);
 #endif
 
+#if SCHEDULER_TYPE == SCHEDULER_EVENT
+/**
+ * Event of each task: the bit of its priority, Scheduler_task_x_priority.
+ * Every task needs a priority of its own, 0 to 7, as it only runs once its
+ * event is posted.
+ */
+#ifdef Scheduler_task_1
+#ifndef Scheduler_task_1_priority
+#error Scheduler_task_1_priority must be defined in conf_scheduler.h file
+#endif
+#if (Scheduler_task_1_priority < 0) || (Scheduler_task_1_priority > 7)
+#error Scheduler_task_1_priority must be 0 to 7
+#endif
+#define Scheduler_task_1_event (1 << Scheduler_task_1_priority)
+#else
+#define Scheduler_task_1_event 0
+#endif
+#ifdef Scheduler_task_2
+#ifndef Scheduler_task_2_priority
+#error Scheduler_task_2_priority must be defined in conf_scheduler.h file
+#endif
+#if (Scheduler_task_2_priority < 0) || (Scheduler_task_2_priority > 7)
+#error Scheduler_task_2_priority must be 0 to 7
+#endif
+#define Scheduler_task_2_event (1 << Scheduler_task_2_priority)
+#else
+#define Scheduler_task_2_event 0
+#endif
+#ifdef Scheduler_task_3
+#ifndef Scheduler_task_3_priority
+#error Scheduler_task_3_priority must be defined in conf_scheduler.h file
+#endif
+#if (Scheduler_task_3_priority < 0) || (Scheduler_task_3_priority > 7)
+#error Scheduler_task_3_priority must be 0 to 7
+#endif
+#define Scheduler_task_3_event (1 << Scheduler_task_3_priority)
+#else
+#define Scheduler_task_3_event 0
+#endif
+#ifdef Scheduler_task_4
+#ifndef Scheduler_task_4_priority
+#error Scheduler_task_4_priority must be defined in conf_scheduler.h file
+#endif
+#if (Scheduler_task_4_priority < 0) || (Scheduler_task_4_priority > 7)
+#error Scheduler_task_4_priority must be 0 to 7
+#endif
+#define Scheduler_task_4_event (1 << Scheduler_task_4_priority)
+#else
+#define Scheduler_task_4_event 0
+#endif
+#ifdef Scheduler_task_5
+#ifndef Scheduler_task_5_priority
+#error Scheduler_task_5_priority must be defined in conf_scheduler.h file
+#endif
+#if (Scheduler_task_5_priority < 0) || (Scheduler_task_5_priority > 7)
+#error Scheduler_task_5_priority must be 0 to 7
+#endif
+#define Scheduler_task_5_event (1 << Scheduler_task_5_priority)
+#else
+#define Scheduler_task_5_event 0
+#endif
+#ifdef Scheduler_task_6
+#ifndef Scheduler_task_6_priority
+#error Scheduler_task_6_priority must be defined in conf_scheduler.h file
+#endif
+#if (Scheduler_task_6_priority < 0) || (Scheduler_task_6_priority > 7)
+#error Scheduler_task_6_priority must be 0 to 7
+#endif
+#define Scheduler_task_6_event (1 << Scheduler_task_6_priority)
+#else
+#define Scheduler_task_6_event 0
+#endif
+#ifdef Scheduler_task_7
+#ifndef Scheduler_task_7_priority
+#error Scheduler_task_7_priority must be defined in conf_scheduler.h file
+#endif
+#if (Scheduler_task_7_priority < 0) || (Scheduler_task_7_priority > 7)
+#error Scheduler_task_7_priority must be 0 to 7
+#endif
+#define Scheduler_task_7_event (1 << Scheduler_task_7_priority)
+#else
+#define Scheduler_task_7_event 0
+#endif
+#ifdef Scheduler_task_8
+#ifndef Scheduler_task_8_priority
+#error Scheduler_task_8_priority must be defined in conf_scheduler.h file
+#endif
+#if (Scheduler_task_8_priority < 0) || (Scheduler_task_8_priority > 7)
+#error Scheduler_task_8_priority must be 0 to 7
+#endif
+#define Scheduler_task_8_event (1 << Scheduler_task_8_priority)
+#else
+#define Scheduler_task_8_event 0
+#endif
+#ifdef Scheduler_task_9
+#ifndef Scheduler_task_9_priority
+#error Scheduler_task_9_priority must be defined in conf_scheduler.h file
+#endif
+#if (Scheduler_task_9_priority < 0) || (Scheduler_task_9_priority > 7)
+#error Scheduler_task_9_priority must be 0 to 7
+#endif
+#define Scheduler_task_9_event (1 << Scheduler_task_9_priority)
+#else
+#define Scheduler_task_9_event 0
+#endif
+#ifdef Scheduler_task_10
+#ifndef Scheduler_task_10_priority
+#error Scheduler_task_10_priority must be defined in conf_scheduler.h file
+#endif
+#if (Scheduler_task_10_priority < 0) || (Scheduler_task_10_priority > 7)
+#error Scheduler_task_10_priority must be 0 to 7
+#endif
+#define Scheduler_task_10_event (1 << Scheduler_task_10_priority)
+#else
+#define Scheduler_task_10_event 0
+#endif
+#ifdef Scheduler_task_11
+#ifndef Scheduler_task_11_priority
+#error Scheduler_task_11_priority must be defined in conf_scheduler.h file
+#endif
+#if (Scheduler_task_11_priority < 0) || (Scheduler_task_11_priority > 7)
+#error Scheduler_task_11_priority must be 0 to 7
+#endif
+#define Scheduler_task_11_event (1 << Scheduler_task_11_priority)
+#else
+#define Scheduler_task_11_event 0
+#endif
+
+/// Events of all the tasks
+#define SCHEDULER_EVENTS (Scheduler_task_1_event | Scheduler_task_2_event | \
+                          Scheduler_task_3_event | Scheduler_task_4_event | \
+                          Scheduler_task_5_event | Scheduler_task_6_event | \
+                          Scheduler_task_7_event | Scheduler_task_8_event | \
+                          Scheduler_task_9_event | Scheduler_task_10_event | \
+                          Scheduler_task_11_event)
+
+/// Sum of the events of all the tasks, above SCHEDULER_EVENTS if two tasks share an event
+#define SCHEDULER_EVENTS_SUM (Scheduler_task_1_event + Scheduler_task_2_event + \
+                              Scheduler_task_3_event + Scheduler_task_4_event + \
+                              Scheduler_task_5_event + Scheduler_task_6_event + \
+                              Scheduler_task_7_event + Scheduler_task_8_event + \
+                              Scheduler_task_9_event + Scheduler_task_10_event + \
+                              Scheduler_task_11_event)
+#if SCHEDULER_EVENTS_SUM != SCHEDULER_EVENTS
+#error Each task must have its own Scheduler_task_x_priority
+#endif
+#endif
+
+#ifndef SCHEDULER_SLEEP
+#define SCHEDULER_SLEEP false
+#endif
+#if (SCHEDULER_SLEEP == true) && (SCHEDULER_TYPE != SCHEDULER_EVENT)
+#error SCHEDULER_SLEEP needs SCHEDULER_EVENT
+#endif
+
+#ifndef SCHEDULER_PROFILE
+#define SCHEDULER_PROFILE false
+#endif
+#if (SCHEDULER_PROFILE == true) && (SCHEDULER_TYPE != SCHEDULER_EVENT)
+#error SCHEDULER_PROFILE needs SCHEDULER_EVENT
+#endif
+
+/// Profiles are kept: the task calls with SCHEDULER_PROFILE, the wake-up latency with SCHEDULER_SLEEP
+#if (SCHEDULER_PROFILE == true) || (SCHEDULER_SLEEP == true)
+#define SCHEDULER_PROFILING        true
+#else
+#define SCHEDULER_PROFILING        false
+#endif
+#if SCHEDULER_PROFILING == true
+#ifndef SCHEDULER_PROFILE_CLOCK
+#error SCHEDULER_PROFILE_CLOCK must be defined in conf_scheduler.h file
+#endif
+/**
+ * Histogram bins of the task calls: bin n counts the calls shorter than
+ * 4^(n+1) ticks, the last one all the longer calls
+ */
+#define SCHEDULER_PROFILE_BINS     8
+
+/**
+ * Values of a task profile, see scheduler_profile_value(). Durations are in
+ * ticks of SCHEDULER_PROFILE_CLOCK.
+ */
+#define SCHEDULER_PROFILE_CALLS    0   ///< Number of calls
+#define SCHEDULER_PROFILE_MEAN     1   ///< Mean duration
+#define SCHEDULER_PROFILE_MIN      2   ///< Shortest call
+#define SCHEDULER_PROFILE_MAX      3   ///< Longest call, 0xFFFF if it did not fit
+#define SCHEDULER_PROFILE_BIN      4   ///< First histogram bin
+#define SCHEDULER_PROFILE_VALUES   (SCHEDULER_PROFILE_BIN + SCHEDULER_PROFILE_BINS)
+#if SCHEDULER_PROFILE == true
+/// Task profiles, one per priority
+#define SCHEDULER_PROFILE_TASKS    8
+#else
+#define SCHEDULER_PROFILE_TASKS    0
+#endif
+#if SCHEDULER_SLEEP == true
+/**
+ * Profile of the wake-up latency, after the task profiles: from the return
+ * of the interrupt ending a sleep to the start of the next task
+ */
+#define SCHEDULER_PROFILE_WAKE     SCHEDULER_PROFILE_TASKS
+#define SCHEDULER_PROFILE_FIRST_USER (SCHEDULER_PROFILE_TASKS + 1)
+#else
+#define SCHEDULER_PROFILE_FIRST_USER SCHEDULER_PROFILE_TASKS
+#endif
+#if (SCHEDULER_PROFILE == true) && defined(SCHEDULER_PROFILE_USER)
+#define SCHEDULER_PROFILE_USERS    SCHEDULER_PROFILE_USER
+#else
+#define SCHEDULER_PROFILE_USERS    0
+#endif
+/**
+ * Profiles: the tasks by priority, the wake-up latency, then the
+ * SCHEDULER_PROFILE_USER profiles fed with scheduler_profile_record(), the
+ * last ones with SCHEDULER_PROFILE only
+ */
+#define SCHEDULER_PROFILES         (SCHEDULER_PROFILE_FIRST_USER + SCHEDULER_PROFILE_USERS)
+/// Values of all the profiles
+#define SCHEDULER_PROFILE_COUNT    (SCHEDULER_PROFILES * SCHEDULER_PROFILE_VALUES)
+#endif
+
 //_____ D E F I N I T I O N ____________________________________________________
-#if SCHEDULER_TYPE != SCHEDULER_FREE
+#if (SCHEDULER_TYPE != SCHEDULER_FREE) && (SCHEDULER_TYPE != SCHEDULER_EVENT)
 extern bit scheduler_tick_flag;
 #endif
 
+/**
+ * Events posted to the tasks, one bit per event, see Scheduler_task_x_event.
+ * A task's event bit is its priority, bit 0 being served first.
+ * Posted with Scheduler_post() or Scheduler_post_from_isr(), whatever the
+ * SCHEDULER_TYPE; only SCHEDULER_EVENT waits for them.
+ */
+extern volatile uint8_t scheduler_events;
+
 #ifdef TOKEN_MODE
 extern unsigned char token;
 #define TOKEN_FREE      0
@@ -176,12 +407,20 @@ void scheduler_init(void);
 void scheduler_tasks(void);
 void scheduler(void);
 void scheduler_empty_fct(void);
+#if SCHEDULER_PROFILING == true
+uint32_t scheduler_profile_value(uint8_t index);
+void scheduler_profile_clear(void);
+void scheduler_profile_record(uint8_t profile, uint16_t ticks);
+#endif
 
 #ifndef SCHEDULER_TYPE
 #error You must define SCHEDULER_TYPE in config.h file
 #elif SCHEDULER_TYPE == SCHEDULER_FREE
 #define Scheduler_set_tick_flag()
 #define Scheduler_reset_tick_flag()
+#elif SCHEDULER_TYPE == SCHEDULER_EVENT
+#define Scheduler_set_tick_flag()
+#define Scheduler_reset_tick_flag()
 #elif SCHEDULER_TYPE == SCHEDULER_TIMED
 #define Scheduler_new_schedule()      Wait_semaphore(scheduler_tick_flag)
 #define Scheduler_set_tick_flag()     (scheduler_tick_flag = true)
@@ -206,4 +445,9 @@ void scheduler_empty_fct(void);
 #define Scheduler_call_next_init()
 #endif
 
+/// Post events to the tasks from an interrupt handler
+#define Scheduler_post_from_isr(e)    (scheduler_events |= (e))
+/// Post events to the tasks from a task
+#define Scheduler_post(e)             do { ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { scheduler_events |= (e); } } while (0)
+
 #endif /// _SCHEDULER_H_
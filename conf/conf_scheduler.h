@@ -45,12 +45,59 @@
 #define _CONF_SCHEDULER_H_
 
 /*--------------- SCHEDULER CONFIGURATION --------------*/
-#define SCHEDULER_TYPE          SCHEDULER_FREE  // SCHEDULER_(TIMED|TASK|FREE|CUSTOM)
+#define SCHEDULER_TYPE          SCHEDULER_EVENT // SCHEDULER_(TIMED|TASK|FREE|EVENT|CUSTOM)
+
+
+/**
+ * Task priorities, 0 being the highest. After each task, the ready task of
+ * highest priority runs: the HID report first, then the S.N.A.P. packets that
+ * feed it, then USB housekeeping and control requests.
+ */
 #define Scheduler_task_1_init   usb_task_init
 #define Scheduler_task_1        usb_task
+#define Scheduler_task_1_priority 2
 #define Scheduler_task_2_init   hid_task_init
 #define Scheduler_task_2        hid_task
+#define Scheduler_task_2_priority 0
 #define Scheduler_task_3_init   snap_task_init
 #define Scheduler_task_3        snap_task
+#define Scheduler_task_3_priority 1
+
+/**
+ * Events waking the tasks, see Scheduler_post()
+ *
+ * - EVENT_USB:  USB bus events, VBUS changes included, SETUP packets on
+ *               endpoint 0 and start of frame
+ * - EVENT_HID:  start of frame, OUT packets on EP_HID_OUT and the report
+ *               deadline (timer 1 compare A)
+ * - EVENT_SNAP: byte received by the USART, bytes tunnelled through USB,
+ *               packet queued by a receiver, and timer 1 compare B for the
+ *               baud rate timers
+ */
+#define EVENT_USB               ( 1 << Scheduler_task_1_priority )
+#define EVENT_HID               ( 1 << Scheduler_task_2_priority )
+#define EVENT_SNAP              ( 1 << Scheduler_task_3_priority )
+
+/**
+ * Sleep in idle mode while no event is pending, to be woken up by the next
+ * USB, USART or timer interrupt. Every source the tasks serve posts the
+ * event above from its interrupt. Needs SCHEDULER_EVENT.
+ *
+ * The wake-up latency is kept as a profile, read with the HID feature report
+ * after the S.N.A.P. counters, see scheduler_profile_value().
+ */
+#define SCHEDULER_SLEEP         true
+
+/**
+ * Time every task call with the free running timer 1, see
+ * scheduler_profile_value(). The profiles are read with the HID feature
+ * report after the S.N.A.P. counters, followed with SCHEDULER_SLEEP by the
+ * wake-up latency, then by the user profiles. Needs SCHEDULER_EVENT.
+ */
+#define SCHEDULER_PROFILE       false
+/// Timer 1 clock of the profiles, see TIMER1_CLOCK in config.h
+#define SCHEDULER_PROFILE_CLOCK TIMER1_CLOCK
+/// Profiles fed by the tasks, after the others: the HID report staleness, see HID_REPORT_DEADLINE
+#define SCHEDULER_PROFILE_USER  1
 
 #endif  /// _CONF_SCHEDULER_H_
@@ -0,0 +1,140 @@
+/**
+ * @file
+ *
+ * @brief This file contains the S.N.A.P. protocol configuration
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+#ifndef _CONF_SNAP_H_
+#define _CONF_SNAP_H_
+
+/**
+ * @defgroup snap_conf S.N.A.P. configuration
+ * @{
+ */
+
+/**
+ * @brief Largest number of data bytes accepted in a received packet
+ *
+ * Must be one of the sizes encodable in HDB1::NDB (0-8, 16, 32, 64, 128, 256 or 512).
+ * Packets announcing a larger NDB are dropped as soon as HDB1 is received.
+ */
+#define SNAP_MAX_DATA           64
+
+/**
+ * @brief Address of this node
+ *
+ * Packets are only received if their destination address is this address,
+ * SNAP_BROADCAST or an address added with snap_filter_add().
+ */
+#define SNAP_NODE_ADDRESS       0x01
+
+/**
+ * @brief Number of addresses in the destination filter, SNAP_NODE_ADDRESS included
+ */
+#define SNAP_FILTER_SIZE        4
+
+/**
+ * @brief Number of packet buffers in the pool
+ *
+ * Each buffer holds one packet of up to SNAP_MAX_DATA data bytes, from the
+ * first byte received until its consumer releases it. Two buffers per link
+ * hold the copies of EDM_3TX packets being voted on. Must be a power of 2,
+ * 16 at most.
+ */
+#define SNAP_POOL_SIZE          16
+
+/**
+ * @brief Number of sequenced packets the sender may have in flight
+ *
+ * Packets received ahead of a missing one are held in pool buffers. Each link
+ * has its own window, EDM_3TX copies and packet being received, so the
+ * windows must leave room in the pool for all of them: at most
+ * SNAP_POOL_SIZE - 3 with the USART alone, SNAP_POOL_SIZE / 2 - 3 with
+ * SNAP_USB_TUNNEL. 8 at most.
+ */
+#define SNAP_WINDOW_SIZE        4
+
+/**
+ * @brief Most SRAM the pool may take, bytes
+ *
+ * The build fails if SNAP_POOL_SIZE buffers of SNAP_MAX_DATA data bytes, with
+ * their FEC trailer if SNAP_FEC_SUPPORT, exceed it. The at90usb1287 has 8 KB
+ * of SRAM, shared with the USART buffers, the USB tunnel and the stack.
+ */
+#define SNAP_POOL_MAX_BYTES     3072
+
+/**
+ * @brief Support forward error correction (EDM_FEC)
+ *
+ * The FEC trailer holds one parity byte per header and data byte, which
+ * almost doubles the size of each pool buffer: with 16 buffers of 64 data
+ * bytes the pool takes 2720 bytes of SRAM instead of 1584.
+ *
+ * Possible values true or false
+ */
+#define SNAP_FEC_SUPPORT        true
+
+/**
+ * @brief Run the receiver inside the USART receive interrupt
+ *
+ * When true, framing and error detection are done as each byte arrives and
+ * snap_task() only processes complete packets. When false, snap_task() drains
+ * the USART receive buffer itself.
+ *
+ * Possible values true or false
+ */
+#define SNAP_RX_IN_ISR          false
+
+/**
+ * @brief Receive S.N.A.P. packets through USB HID reports as well
+ *
+ * The report descriptor gains a vendor collection with its own report ID,
+ * REPORT_ID_SNAP, whose output reports carry up to 62 S.N.A.P. bytes each,
+ * see hid_report_tunnel(). They are received by a second receiver, so packets
+ * may arrive on both links at the same time. Answers to them are read back
+ * with HID GET_REPORT requests for a REPORT_ID_SNAP input report, see
+ * snap_usb.h; EDM_3TX voting and the sliding window are kept apart for each
+ * link.
+ *
+ * The guitar reports then start with their own report ID, REPORT_ID_GUITAR,
+ * which a console expecting the reports of the original guitar does not
+ * accept: disable the tunnel for it.
+ *
+ * Possible values true or false
+ */
+#define SNAP_USB_TUNNEL         true
+
+/**
+ * @brief Size of the buffer of answers waiting to be read through USB, in bytes
+ *
+ * Power of 2, 256 at most.
+ */
+#define SNAP_USB_TX_BUFFER_SIZE 128
+
+/**
+ * @brief Fastest USART baud rate code accepted by SNAP_CMD_BAUD, see USART_BAUD_xxx
+ */
+#define SNAP_BAUD_MAX           USART_BAUD_1M
+
+/**
+ * @brief Milliseconds a new baud rate has to receive a packet in, timed with timer 1
+ */
+#define SNAP_BAUD_TRIAL         250
+
+/**
+ * @brief Receive errors per second above which the USART falls back to USART_BAUD
+ *
+ * Packets failing error detection and bytes lost to receive buffer overflows
+ * are counted.
+ */
+#define SNAP_BAUD_MAX_ERRORS    16
+
+///@}
+
+#endif // _CONF_SNAP_H_
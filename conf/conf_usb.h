@@ -45,6 +45,7 @@
 
 #include "modules/usb/usb_commun.h"
 #include "modules/usb/usb_commun_hid.h"
+#include "modules/scheduler/scheduler.h"
 
 /**
  * @defgroup usb_general_conf USB application configuration
@@ -229,10 +230,12 @@ extern void host_suspend_action( void );
 // write here the action to associate to each USB event
 // be carefull not to waste time in order not disturbing the functions
 #define Usb_sof_action()         sof_action();
-#define Usb_wake_up_action()
-#define Usb_resume_action()
-#define Usb_suspend_action()
-#define Usb_reset_action()
+#define Usb_wake_up_action()     Scheduler_post_from_isr( EVENT_USB );
+#define Usb_resume_action()      Scheduler_post_from_isr( EVENT_USB );
+#define Usb_suspend_action()     Scheduler_post_from_isr( EVENT_USB );
+#define Usb_reset_action()       Scheduler_post_from_isr( EVENT_USB );
+#define Usb_vbus_change_action() Scheduler_post_from_isr( EVENT_USB );
+#define Usb_endpoint_action(ep)  Scheduler_post_from_isr( ( EP_CONTROL == ( ep ) ) ? EVENT_USB : EVENT_HID );
 #define Usb_vbus_on_action()
 #define Usb_vbus_off_action()
 #define Usb_set_configuration_action()
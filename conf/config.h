@@ -57,6 +57,8 @@
  */
 
 #include "conf/conf_scheduler.h" ///< Scheduler tasks declaration
+#include "modules/scheduler/scheduler.h"
+#include "conf/conf_snap.h"      ///< S.N.A.P. protocol configuration
 // Board defines (do not change these settings)
 #define  STK525   1
 #define  USBKEY   2
@@ -91,15 +93,110 @@
 // -------- END Generic Configuration -------------------------------------
 
 // UART Sample configuration, if we have one ... __________________________
-#define USART_BAUDRATE        57600
+/// Baud rate code at start-up and after a fallback, see USART_BAUD_xxx
+#define USART_BAUD            USART_BAUD_57600
+
+/// Number of stop bits, 1 or 2
+#define USART_STOP_BITS       2
 
 #define uart_putchar putchar
 #define r_uart_ptchar int
 #define p_uart_ptchar int
 
-#define USART_RX_BUFFER_SIZE 128     /* 2,4,8,16,32,64,128 or 256 bytes */
+#define USART_RX_BUFFER_SIZE 128     /* power of 2, up to 32768 bytes */
 #define USART_TX_BUFFER_SIZE 128     /* 2,4,8,16,32,64,128 or 256 bytes */
 
+/**
+ * @brief What the receive interrupt does with a byte received into a full buffer
+ *
+ * - USART_RX_DROP_NEWEST: the received byte is dropped
+ * - USART_RX_DROP_OLDEST: the oldest buffered byte is dropped to make room
+ * - USART_RX_FLOW_CONTROL: the received byte is dropped, but the RTS line
+ *   stops the sender before: it is held high from the moment USART_RTS_HIGH
+ *   bytes are buffered until no more than USART_RTS_LOW are left
+ *
+ * Every lost byte is counted, see USART0_RxOverflows().
+ */
+#define USART_RX_OVERFLOW       USART_RX_DROP_NEWEST
+
+/// RTS line for USART_RX_FLOW_CONTROL, high to stop the sender
+#define USART_RTS_PORT          PORTD
+#define USART_RTS_DDR           DDRD
+#define USART_RTS_BIT           PIND1
+
+/// Buffered bytes stopping the sender, leaving room for the bytes already on their way
+#define USART_RTS_HIGH          ( USART_RX_BUFFER_SIZE - 16 )
+/// Buffered bytes letting the sender go on
+#define USART_RTS_LOW           ( USART_RX_BUFFER_SIZE / 4 )
+
+/**
+ * @brief Pause transmission while the peer holds the CTS line high
+ *
+ * The CTS line must be one of the external interrupt pins INT0 to INT3.
+ *
+ * Possible values true or false
+ */
+#define USART_TX_FLOW_CONTROL   false
+
+/// CTS line for USART_TX_FLOW_CONTROL, high when the peer cannot receive
+#define USART_CTS_PIN           PIND
+#define USART_CTS_BIT           PIND0
+#define USART_CTS_INT           INT0
+#define USART_CTS_vect          INT0_vect
+
+/**
+ * @brief Action run by the receive interrupt for each received byte
+ *
+ * When defined, received bytes are handed to this action instead of being
+ * stored in the receive buffer.
+ */
+#if (SNAP_RX_IN_ISR == true)
+#define Usart_rx_action(c)      snap_rx_isr(c)
+extern void snap_rx_isr( unsigned char c );
+#endif
+
+/**
+ * @brief Action run by the receive interrupt after each received byte
+ */
+#define Usart_rx_event()        Scheduler_post_from_isr( EVENT_SNAP )
+
+/**
+ * @brief Action run by the transmit complete interrupt once the line is idle
+ *
+ * When defined, the action is run after the last byte of the transmit buffer
+ * has been shifted out, e.g. to turn an RS-485 transceiver back to receive.
+ */
+//#define Usart_tx_done_action()  ( PORTE &= ~( 1 << PINE6 ) )
+
+// HID report configuration ______________________________________________
+
+/// Number of timed events waiting for their frame, power of 2 up to 128
+#define HID_EVENT_QUEUE_SIZE    32
+
+/// Member of struct hid_report set by timed events with the hat switch and buttons
+#define HID_EVENT_AXIS          x
+
+/**
+ * Build the IN report just before the frame in which the host is expected to
+ * poll it, instead of as soon as the endpoint is free. The poll frames are
+ * learnt at each Start Of Frame, and timer 1 wakes hid_task up in the frame
+ * before the poll.
+ */
+#define HID_REPORT_DEADLINE     false
+/// Time left between the end of the report and the frame of the poll, us
+#define HID_REPORT_MARGIN       100
+
+// Timer configuration ___________________________________________________
+
+/**
+ * Clock of timer 1, running free for the scheduler profiler, the HID report
+ * deadline and the S.N.A.P. baud rate timers: clk/8, one tick per us with
+ * FOSC 8000
+ */
+#define TIMER1_CLOCK            ( 1 << CS11 )
+/// Timer 1 ticks in us microseconds, for TIMER1_CLOCK
+#define Timer1_ticks(us)        ( ( us ) * ( FOSC / 1000 ) / 8 )
+
 // ADC Sample configuration, if we have one ... ___________________________
 
 /// ADC Prescaler value
@@ -0,0 +1,221 @@
+/**
+ * @file
+ *
+ * @brief Timed HID report events
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+//_____  I N C L U D E S _______________________________________________________
+
+#include <util/atomic.h>
+#include "hid_event.h"
+#include "hid_task.h"
+
+//_____ M A C R O S ____________________________________________________________
+
+#define HID_EVENT_QUEUE_MASK    ( HID_EVENT_QUEUE_SIZE - 1 )
+#if ( HID_EVENT_QUEUE_SIZE & HID_EVENT_QUEUE_MASK ) || ( HID_EVENT_QUEUE_SIZE > 128 )
+#error HID_EVENT_QUEUE_SIZE must be a power of 2, 128 at most
+#endif
+
+//_____ V A R I A B L E S ______________________________________________________
+
+/// Pending events ordered by frame, from tail to head
+static struct hid_event queue[HID_EVENT_QUEUE_SIZE];
+static volatile uint8_t queue_head;
+static volatile uint8_t queue_tail;
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+/**
+ * @brief Drop every pending event
+ */
+void hid_event_init( void )
+{
+    queue_head = 0;
+    queue_tail = 0;
+}
+
+/**
+ * @brief Current frame number
+ */
+uint16_t hid_event_frame( void )
+{
+    uint16_t frame;
+
+    ATOMIC_BLOCK( ATOMIC_RESTORESTATE )
+    {
+        frame = cpt_sof;
+    }
+    return frame;
+}
+
+/**
+ * @brief Queue an event
+ *
+ * Events due in the same frame are applied in the order they were posted.
+ * Posting events in frame order costs no more than appending them; an event
+ * due before pending ones is moved into place with interrupts disabled.
+ *
+ * @param event     event to copy into the queue
+ *
+ * @return false if the queue is full
+ */
+bool hid_event_post( const struct hid_event *event )
+{
+    bool posted = false;
+    uint8_t i;
+
+    ATOMIC_BLOCK( ATOMIC_RESTORESTATE )
+    {
+        i = queue_head;
+        if( ( uint8_t )( i - queue_tail ) < HID_EVENT_QUEUE_SIZE )
+        {
+            while( ( i != queue_tail ) &&
+                   Is_frame_after( queue[( i - 1 ) & HID_EVENT_QUEUE_MASK].frame, event->frame ) )
+            {
+                queue[i & HID_EVENT_QUEUE_MASK] = queue[( i - 1 ) & HID_EVENT_QUEUE_MASK];
+                --i;
+            }
+            queue[i & HID_EVENT_QUEUE_MASK] = *event;
+            ++queue_head;
+            posted = true;
+        }
+    }
+    return posted;
+}
+
+/**
+ * @brief State of the controls once every queued event is applied
+ *
+ * @param event     filled with the last event queued, or the report if none
+ */
+static void hid_event_last( struct hid_event *event )
+{
+    ATOMIC_BLOCK( ATOMIC_RESTORESTATE )
+    {
+        if( queue_tail != queue_head )
+        {
+            *event = queue[( queue_head - 1 ) & HID_EVENT_QUEUE_MASK];
+        }
+        else
+        {
+            event->frame = cpt_sof;
+            event->buttons = report.buttons.raw;
+            event->hat = report.hat;
+            event->axis = report.HID_EVENT_AXIS;
+        }
+    }
+}
+
+/**
+ * @brief Apply every event due to the HID report
+ *
+ * Called by the Start Of Frame interrupt.
+ *
+ * @param frame     current frame number
+ */
+void hid_event_apply( uint16_t frame )
+{
+    struct hid_event *event;
+
+    while( queue_tail != queue_head )
+    {
+        event = &queue[queue_tail & HID_EVENT_QUEUE_MASK];
+        if( Is_frame_after( event->frame, frame ) )
+            break;
+
+        report.buttons.raw = event->buttons;
+        report.hat = event->hat;
+        report.HID_EVENT_AXIS = event->axis;
+        ++queue_tail;
+    }
+}
+
+/**
+ * @brief Queue the event carried by a S.N.A.P. packet
+ *
+ * @param data      data bytes, starting with HID_EVENT_MSG
+ * @param length    number of data bytes
+ *
+ * @return false if the packet is too short or the queue is full
+ */
+bool hid_event_receive( const uint8_t *data, uint16_t length )
+{
+    struct hid_event event;
+
+    if( length < 7 )
+        return false;
+
+    event.frame = ( ( uint16_t )data[1] << 8 ) | data[2];
+    event.buttons = ( ( uint16_t )data[3] << 8 ) | data[4];
+    event.hat = data[5];
+    event.axis = data[6];
+    return hid_event_post( &event );
+}
+
+/**
+ * @brief Queue the batch of events carried by a S.N.A.P. packet
+ *
+ * @param data      data bytes, starting with HID_EVENT_BATCH_MSG
+ * @param length    number of data bytes
+ *
+ * @return false if the packet is too short, ends inside an event or the
+ * queue is full; the events before are queued
+ */
+bool hid_event_receive_batch( const uint8_t *data, uint16_t length )
+{
+    const uint8_t *end = data + length;
+    struct hid_event event;
+    uint8_t flags;
+    uint8_t size;
+
+    if( length < 3 )
+        return false;
+
+    hid_event_last( &event );
+    event.frame = ( ( uint16_t )data[1] << 8 ) | data[2];
+    data += 3;
+
+    while( end - data >= 2 )
+    {
+        flags = data[1];
+        if( 0 == flags )
+            break;
+
+        size = 2 + ( ( flags & HID_EVENT_BUTTONS_LO ) ? 1 : 0 ) +
+                   ( ( flags & HID_EVENT_BUTTONS_HI ) ? 1 : 0 ) +
+                   ( ( flags & HID_EVENT_HAT ) ? 1 : 0 ) +
+                   ( ( flags & HID_EVENT_AXIS_VALUE ) ? 1 : 0 );
+        if( end - data < size )
+            return false;
+
+        event.frame += data[0];
+        data += 2;
+        if( flags & HID_EVENT_BUTTONS_LO )
+        {
+            event.buttons ^= *data++;
+        }
+        if( flags & HID_EVENT_BUTTONS_HI )
+        {
+            event.buttons ^= ( uint16_t )*data++ << 8;
+        }
+        if( flags & HID_EVENT_HAT )
+        {
+            event.hat = *data++;
+        }
+        if( flags & HID_EVENT_AXIS_VALUE )
+        {
+            event.axis = *data++;
+        }
+
+        if( !hid_event_post( &event ) )
+            return false;
+    }
+    return true;
+}
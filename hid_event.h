@@ -0,0 +1,106 @@
+/**
+ * @file
+ *
+ * @brief Timed HID report events
+ *
+ * Events received ahead of time are held in a queue ordered by USB frame
+ * number, and applied to the HID report by the Start Of Frame interrupt of
+ * the frame they are due, so that the timing of the host is kept regardless
+ * of the link latency.
+ *
+ * Frame numbers count Start Of Frame interrupts (1ms) modulo 65536, see
+ * cpt_sof. Events due in a frame that has already passed are applied at the
+ * next Start Of Frame.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+#ifndef _HID_EVENT_H_
+#define _HID_EVENT_H_
+
+//_____ I N C L U D E S ________________________________________________________
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "config.h"
+
+//_____ M A C R O S ____________________________________________________________
+
+/// Frame a is later than frame b, modulo 65536
+#define Is_frame_after(a, b)    ( ( int16_t )( ( a ) - ( b ) ) > 0 )
+
+/** @brief First data byte of a S.N.A.P. packet carrying one event
+ *
+ * <PRE>
+ * DB1      HID_EVENT_MSG
+ * DB2-DB3  frame number, most significant byte first
+ * DB4-DB5  buttons, as report.buttons.raw, most significant byte first
+ * DB6      hat switch
+ * DB7      HID_EVENT_AXIS value
+ * </PRE>
+ */
+#define HID_EVENT_MSG           ( ( uint8_t ) 0x01 )
+
+/** @brief First data byte of a S.N.A.P. packet carrying a batch of events
+ *
+ * <PRE>
+ * DB1      HID_EVENT_BATCH_MSG
+ * DB2-DB3  frame number, most significant byte first
+ * DB4...   events
+ * </PRE>
+ *
+ * Each event only holds what changed since the previous one, which for the
+ * first event of the batch is the last event queued, or the report if none:
+ *
+ * <PRE>
+ * byte 1   frames since the previous event, or since DB2-DB3 for the first
+ * byte 2   HID_EVENT_xxx flags of the bytes following
+ * ...      buttons low byte XOR mask, buttons high byte XOR mask, hat
+ *          switch, HID_EVENT_AXIS value, in this order, if flagged
+ * </PRE>
+ *
+ * An event without any flag ends the batch, so that packets can be padded
+ * with zeros up to an HDB1::NDB size.
+ */
+#define HID_EVENT_BATCH_MSG     ( ( uint8_t ) 0x02 )
+
+/// Batched event flag: XOR mask of buttons 1-8 follows
+#define HID_EVENT_BUTTONS_LO    ( ( uint8_t ) 0x01 )
+/// Batched event flag: XOR mask of buttons 9-13 follows
+#define HID_EVENT_BUTTONS_HI    ( ( uint8_t ) 0x02 )
+/// Batched event flag: hat switch follows
+#define HID_EVENT_HAT           ( ( uint8_t ) 0x04 )
+/// Batched event flag: HID_EVENT_AXIS value follows
+#define HID_EVENT_AXIS_VALUE    ( ( uint8_t ) 0x08 )
+
+//_____ T Y P E S ______________________________________________________________
+
+/**
+ * @brief State of the controls from a given frame on
+ */
+struct hid_event
+{
+    /// Frame number the event is due
+    uint16_t frame;
+    /// Buttons, as report.buttons.raw
+    uint16_t buttons;
+    /// Hat switch
+    uint8_t hat;
+    /// HID_EVENT_AXIS value
+    uint8_t axis;
+};
+
+//_____ D E C L A R A T I O N __________________________________________________
+
+void hid_event_init( void );
+uint16_t hid_event_frame( void );
+bool hid_event_post( const struct hid_event *event );
+void hid_event_apply( uint16_t frame );
+bool hid_event_receive( const uint8_t *data, uint16_t length );
+bool hid_event_receive_batch( const uint8_t *data, uint16_t length );
+
+#endif /* _HID_EVENT_H_ */
@@ -43,6 +43,8 @@
 
 //_____  I N C L U D E S _______________________________________________________
 
+#include <avr/interrupt.h>
+#include <util/atomic.h>
 #include "config.h"
 #include "conf_usb.h"
 #include "hid_task.h"
@@ -51,22 +53,56 @@
 #include "modules/usb/device_chap9/usb_standard_request.h"
 #include "usb_specific_request.h"
 #include "lib_mcu/util/start_boot.h"
+#include "modules/scheduler/scheduler.h"
+#include "hid_event.h"
+#include "snap_task.h"
 
 //_____ M A C R O S ____________________________________________________________
 
+#if (HID_REPORT_DEADLINE == true)
+/// Allowance for the wake-up of hid_task and the copy of the report, us
+#define HID_REPORT_LEAD         50
+/// Profile of the report staleness, see scheduler_profile_record()
+#define HID_PROFILE_STALENESS   SCHEDULER_PROFILE_FIRST_USER
+#endif
 
 //_____ V A R I A B L E S ______________________________________________________
 
-volatile uint8_t cpt_sof = 0;
+/// Start Of Frame count, the frame number of timed events
+volatile uint16_t cpt_sof = 0;
 extern uint8_t jump_bootloader;
 uint8_t g_last_joy = 0;
-int report_cnt = 0;
 struct hid_report report;
 
+#if (HID_REPORT_DEADLINE == true)
+/// Frame of the last poll of EP_HID_IN by the host
+static uint16_t poll_frame;
+/// Frames between two polls
+static uint8_t poll_interval = EP_INTERVAL_1;
+/// Frame of the next poll, for which the report is built
+static volatile uint16_t report_frame;
+/// Timer 1 at the last Start Of Frame
+static uint16_t sof_stamp;
+/// Timer 1 when the report waiting in EP_HID_IN was built
+static uint16_t report_stamp;
+/// A report is waiting in EP_HID_IN
+static volatile bool report_built;
+/// The deadline of the report has come
+static volatile bool report_due;
+#if (SCHEDULER_PROFILE == true)
+/// Age of the last report taken by the host, at the start of the frame of the poll
+static volatile uint16_t report_staleness;
+static volatile bool report_polled;
+#endif
+#endif
+
 //_____ D E F I N I T I O N S __________________________________________________
 
 void hid_report_out( void );
 void hid_report_in( void );
+#if (HID_REPORT_DEADLINE == true)
+static void hid_report_poll( uint16_t frame );
+#endif
 
 /**
  * @brief Initialize the target board resources.
@@ -75,6 +111,11 @@ void hid_task_init( void )
 {
     Leds_init();
     Joy_init();
+    hid_event_init();
+#if (HID_REPORT_DEADLINE == true)
+    TCCR1A = 0;
+    TCCR1B = TIMER1_CLOCK;
+#endif
 }
 
 /**
@@ -89,18 +130,35 @@ void hid_task( void )
 
     hid_report_out();
     hid_report_in();
+#if (HID_REPORT_DEADLINE == true) && (SCHEDULER_PROFILE == true)
+    if( report_polled )
+    {
+        report_polled = false;
+        scheduler_profile_record( HID_PROFILE_STALENESS, report_staleness );
+    }
+#endif
 }
 
 /**
  * @brief Get data report from Host
+ *
+ * When SNAP_USB_TUNNEL is enabled, output reports start with their report ID:
+ * REPORT_ID_SNAP reports carry S.N.A.P. bytes, see hid_report_tunnel(), the
+ * guitar output reports are ignored.
  */
 void hid_report_out( void )
 {
     Usb_select_endpoint(EP_HID_OUT);
     if( Is_usb_receive_out() )
     {
+#if (SNAP_USB_TUNNEL == true)
+        if( ( 1 + SNAP_REPORT_SIZE == Usb_byte_counter_8() ) && ( REPORT_ID_SNAP == Usb_read_byte() ) )
+            hid_report_tunnel();
+#endif
         Usb_ack_receive_out();
     }
+    // The next OUT packet wakes hid_task up, see Usb_endpoint_action()
+    Usb_enable_receive_out_interrupt();
 
     // Check if we received DFU mode command from host
     //	if( jump_bootloader )
@@ -114,37 +172,184 @@ void hid_report_out( void )
     //		}
 }
 
+#if (SNAP_USB_TUNNEL == true)
+/**
+ * @brief Feed the S.N.A.P. bytes of a tunnel output report to the receiver
+ *
+ * The report is read from the selected endpoint, its report ID already read:
+ * the first byte is the number of S.N.A.P. bytes following it, the rest of
+ * the SNAP_REPORT_SIZE bytes is padding. The answers are read back with an
+ * input report of the same ID, see usb_hid_get_report_tunnel().
+ *
+ * Wakes the S.N.A.P. task up when bytes were fed.
+ */
+void hid_report_tunnel( void )
+{
+    uint8_t n;
+
+    n = Usb_read_byte();
+    if( n > SNAP_REPORT_SIZE - 1 )
+        n = 0;
+    if( n > 0 )
+        Scheduler_post( EVENT_SNAP );
+    while( n-- )
+    {
+        snap_rx_usb( Usb_read_byte() );
+    }
+}
+#endif
+
 /**
  * @brief Send data report to Host
+ *
+ * The report is copied with interrupts disabled, so that the events applied
+ * by a Start Of Frame are all sent together.
+ *
+ * With HID_REPORT_DEADLINE, the report is only built once its deadline has
+ * come, the events due in the frame of the poll being applied first.
  */
 void hid_report_in( void )
 {
     uint8_t *report_p = ( uint8_t* ) &report;
     int i;
 
+#if (HID_REPORT_DEADLINE == true)
+    if( !report_due )
+        return;
+    report_due = false;
+#endif
+
     Usb_select_endpoint(EP_HID_IN);
     if( !Is_usb_write_enabled() )
         return; // Not ready to send report
 
-    ++report_cnt;
-    report.buttons.raw = (0x1FFF & report_cnt);
+    ATOMIC_BLOCK( ATOMIC_RESTORESTATE )
+    {
+#if (HID_REPORT_DEADLINE == true)
+        // A poll since the Start Of Frame, not to be hidden by the new report
+        hid_report_poll( cpt_sof );
+        hid_event_apply( report_frame );
+#endif
+#if (SNAP_USB_TUNNEL == true)
+        Usb_write_byte( REPORT_ID_GUITAR );
+#endif
+        for( i = 0; i < sizeof( report ); ++i )
+        {
+            Usb_write_byte( report_p[i] ); // Joystick
+        }
+        Usb_ack_in_ready(); // Send data over the USB
+#if (HID_REPORT_DEADLINE == true)
+        report_stamp = TCNT1;
+        report_built = true;
+#endif
+    }
+}
+
+#if (HID_REPORT_DEADLINE == true)
+/**
+ * @brief Look for a poll of EP_HID_IN by the host, interrupts disabled
+ *
+ * A poll either took the report or found the endpoint empty. The interval is
+ * learnt from the frames between two polls, up to EP_INTERVAL_1.
+ *
+ * @param frame     frame in which a poll seen now took place
+ */
+static void hid_report_poll( uint16_t frame )
+{
+    uint8_t endpoint;
+    bool polled = false;
 
-    for( i = 0; i < sizeof( report ); ++i )
+    endpoint = Usb_get_selected_endpoint();
+    Usb_select_endpoint(EP_HID_IN);
+    if( Is_usb_nak_in_sent() )
     {
-        Usb_write_byte( report_p[i] ); // Joystick
+        // Deadline missed
+        Usb_ack_nak_in();
+        polled = true;
+#if (SCHEDULER_PROFILE == true)
+        report_staleness = 0xFFFF;
+        report_polled = true;
+#endif
     }
+    else if( report_built && Is_usb_write_enabled() )
+    {
+        report_built = false;
+        polled = true;
+#if (SCHEDULER_PROFILE == true)
+        // Built during the frame of the poll, fresher than its start
+        report_staleness = ( int16_t )( sof_stamp - report_stamp ) > 0 ? sof_stamp - report_stamp : 0;
+        report_polled = true;
+#endif
+    }
+    Usb_select_endpoint(endpoint);
 
-    Usb_ack_in_ready(); // Send data over the USB
+    if( polled )
+    {
+        if( ( frame != poll_frame ) && ( ( uint16_t )( frame - poll_frame ) <= EP_INTERVAL_1 ) )
+            poll_interval = frame - poll_frame;
+        poll_frame = frame;
+        report_frame = frame + poll_interval;
+    }
+}
+
+/**
+ * @brief Follow the polls of EP_HID_IN and set the deadline of the report
+ *
+ * Called by the Start Of Frame interrupt, before the host may poll in the
+ * new frame, so that a poll seen now took place in the previous frame. When
+ * the next poll is due in the next frame, timer 1 is set to wake hid_task up
+ * HID_REPORT_MARGIN and HID_REPORT_LEAD before it starts.
+ */
+static void hid_report_schedule( void )
+{
+    uint16_t stamp;
+
+    stamp = TCNT1;
+    hid_report_poll( cpt_sof - 1 );
+    sof_stamp = stamp;
+
+    if( !Is_frame_after( report_frame, cpt_sof ) )
+    {
+        // No poll in the frame of the report, expect the next one
+        report_frame += poll_interval;
+        if( !Is_frame_after( report_frame, cpt_sof ) )
+            report_frame = cpt_sof + 1;
+    }
+
+    if( ( uint16_t )( cpt_sof + 1 ) == report_frame )
+    {
+        OCR1A = stamp + Timer1_ticks( 1000 - HID_REPORT_MARGIN - HID_REPORT_LEAD );
+        TIFR1 = ( 1 << OCF1A );
+        TIMSK1 |= ( 1 << OCIE1A );
+    }
+}
+
+/**
+ * @brief Deadline of the report, wakes hid_task up
+ */
+ISR(TIMER1_COMPA_vect)
+{
+    TIMSK1 &= ~( 1 << OCIE1A );
+    report_due = true;
+    Scheduler_post_from_isr( EVENT_HID );
 }
+#endif
 
 /**
  * @brief  Increments the cpt_sof counter
  *
  * Runs each time the USB Start Of Frame interrupt subroutine is executed (1ms)
  *
- * Useful to manage time delays.
+ * Useful to manage time delays. Applies the timed events due in the new frame,
+ * then wakes the USB and HID tasks.
  */
 void sof_action()
 {
     cpt_sof++ ;
+#if (HID_REPORT_DEADLINE == true)
+    if( Is_device_enumerated() )
+        hid_report_schedule();
+#endif
+    hid_event_apply( cpt_sof );
+    Scheduler_post_from_isr( EVENT_USB | EVENT_HID );
 }
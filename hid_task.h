@@ -190,5 +190,14 @@ struct hid_report
     uint16_t iInputx2F;
 };
 
+//_____ D E C L A R A T I O N __________________________________________________
+
+extern volatile uint16_t cpt_sof;
+extern struct hid_report report;
+
+#if (SNAP_USB_TUNNEL == true)
+void hid_report_tunnel( void );
+#endif
+
 #endif /* _HID_TASK_H_ */
 
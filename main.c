@@ -28,9 +28,11 @@
  * @section arch Architecture
  * As illustrated in the figure bellow, the application entry point is located is the main.c file.
  * The main function first performs the initialization of a scheduler module and then runs it in an infinite loop.
- * The scheduler is a simple infinite loop calling all its tasks defined in the conf_scheduler.h file.
- * No real time schedule is performed, when a task ends, the scheduler calls the next task defined in
- * the configuration file (conf_scheduler.h).
+ * The scheduler is an infinite loop running the tasks defined in the conf_scheduler.h file.
+ * Each task has a priority of its own in conf_scheduler.h, which is also the bit of its event, and
+ * only runs once its event is posted: start of frame, endpoint, VBUS and USB bus events for the
+ * USB tasks, received bytes, queued packets and timer 1 for the S.N.A.P. task. When a task ends,
+ * the scheduler runs the task of highest priority with an event pending.
  *
  * The sample usb application is based on two different tasks:
  * - The usb_task  (usb_task.c associated source file), is the task performing the USB low level
@@ -34,24 +34,20 @@
  * SAB = Number of Source Address Bytes
  * PFB = Number of Protocol specific Flag Bytes
  * ACK = ACK/NAK bits
+ *
+ * @note GCC allocates bit-fields starting from the least significant bit, so the fields
+ * are declared from bit 0 upward.
  */
 union HDB2
 {
     struct HDB2_fields
     {
-        /** @brief Number of Destination Address Bytes
-         *
-         * These two bits defines number of destination address bytes in the packet. With the maximum size of
-         * 3 Bytes it gives a total of 16 777 215 different destination node addresses.
-         */
-        uint8_t DAB :2;
-
-        /** @brief Number of Source Address Bytes
+        /** @brief ACK/NAK bits
          *
-         * These two bits defines the number of source address bytes in the packet. With the maximum size of
-         * 3 Bytes, it gives a total of 16 777 215 different source node addresses.
+         * These two bits defines if the sending node requests an ACK/NAK packet in return. These bits also
+         * acts as the actual ACK/NAK response sent from the receiving node.
          */
-        uint8_t SAB :2;
+        uint8_t ACK :2;
 
         /** @brief Number of Protocol specific Flag Bytes
          *
@@ -60,12 +56,19 @@ union HDB2
          */
         uint8_t PFB :2;
 
-        /** @brief ACK/NAK bits
+        /** @brief Number of Source Address Bytes
          *
-         * These two bits defines if the sending node requests an ACK/NAK packet in return. These bits also
-         * acts as the actual ACK/NAK response sent from the receiving node.
+         * These two bits defines the number of source address bytes in the packet. With the maximum size of
+         * 3 Bytes, it gives a total of 16 777 215 different source node addresses.
          */
-        uint8_t ACK :2;
+        uint8_t SAB :2;
+
+        /** @brief Number of Destination Address Bytes
+         *
+         * These two bits defines number of destination address bytes in the packet. With the maximum size of
+         * 3 Bytes it gives a total of 16 777 215 different destination node addresses.
+         */
+        uint8_t DAB :2;
     } fields;
 
     /** @brief Raw Access to HDB2 byte
@@ -128,35 +131,39 @@ union HDB2
  * CMD = CoMmanD mode bit
  * EDM = Error Detection Method
  * NDB = Number of Data Bytes
+ *
+ * @note GCC allocates bit-fields starting from the least significant bit, so the fields
+ * are declared from bit 0 upward.
  */
 union HDB1
 {
     struct HDB1_fields
     {
-        /** @brief Bit 7 - Command mode bit
-         *
-         * This bit indicates what's called command mode. This is an optional feature and if a node is not
-         * implementing it this bit should always be set to zero (CMD=0).
-         *
-         * A node implementing this feature will be able to respond on queries from other nodes as well as
-         * send responses when for example the receiving node can't handle the packet structure in a received
-         * packet. It can be used to scan large networks for nodes and have them respond with their
-         * capabilities or for two nodes negotiating the right packet structure, among other things.
-         *
-         * If this bit is set (CMD=1) it indicates that the data in DB1 contains a command (query or a
-         * response). This results in total 256 different commands.
+        /** @brief Bit 3 to 0 - Number of Data Bytes (NDB)
          *
-         * The range is divided in two half's, commands between 1-127 are queries and commands between
-         * 128-255 are responses. The commands specified to date are the following. Note this is the value in
-         * DB1, not the actual CMD bit.
+         * These four bits defines how many bytes data there is in the packet (0-512 Bytes).
          *
-         * There are some things to think about for this to work properly. The sending node can not use an
-         * higher address range than the receiving node. This is not a problem if the receiving nodes that are
-         * implementing this feature are capable to handle all the address range (i.e. 1-16 777 215). Another
-         * solution is to assign all masters in the network (in a master/slave network) to the low address range
-         * (i.e. between 1-255).
+         * <PRE>
+         * Bit 3 2 1 0
+         *     0 0 0 0  0 Byte
+         *     0 0 0 1  1 Byte
+         *     0 0 1 0  2 Bytes
+         *     0 0 1 1  3 Bytes
+         *     0 1 0 0  4 Bytes
+         *     0 1 0 1  5 Bytes
+         *     0 1 1 0  6 Bytes
+         *     0 1 1 1  7 Bytes
+         *     1 0 0 0  8 Bytes
+         *     1 0 0 1  16 Bytes
+         *     1 0 1 0  32 Bytes
+         *     1 0 1 1  64 Bytes
+         *     1 1 0 0  128 Bytes
+         *     1 1 0 1  256 Bytes
+         *     1 1 1 0  512 Bytes
+         *     1 1 1 1  User Specified
+         * </PRE>
          */
-        uint8_t CMD :1;
+        uint8_t NDB :4;
 
         /** @brief Bit 6 to 4 - Error Detection Method (EDM)
          *
@@ -180,31 +187,30 @@ union HDB1
          */
         uint8_t EDM :3;
 
-        /** @brief Bit 3 to 0 - Number of Data Bytes (NDB)
+        /** @brief Bit 7 - Command mode bit
          *
-         * These four bits defines how many bytes data there is in the packet (0-512 Bytes).
+         * This bit indicates what's called command mode. This is an optional feature and if a node is not
+         * implementing it this bit should always be set to zero (CMD=0).
          *
-         * <PRE>
-         * Bit 3 2 1 0
-         *     0 0 0 0  0 Byte
-         *     0 0 0 1  1 Byte
-         *     0 0 1 0  2 Bytes
-         *     0 0 1 1  3 Bytes
-         *     0 1 0 0  4 Bytes
-         *     0 1 0 1  5 Bytes
-         *     0 1 1 0  6 Bytes
-         *     0 1 1 1  7 Bytes
-         *     1 0 0 0  8 Bytes
-         *     1 0 0 1  16 Bytes
-         *     1 0 1 0  32 Bytes
-         *     1 0 1 1  64 Bytes
-         *     1 1 0 0  128 Bytes
-         *     1 1 0 1  256 Bytes
-         *     1 1 1 0  512 Bytes
-         *     1 1 1 1  User Specified
-         * </PRE>
+         * A node implementing this feature will be able to respond on queries from other nodes as well as
+         * send responses when for example the receiving node can't handle the packet structure in a received
+         * packet. It can be used to scan large networks for nodes and have them respond with their
+         * capabilities or for two nodes negotiating the right packet structure, among other things.
+         *
+         * If this bit is set (CMD=1) it indicates that the data in DB1 contains a command (query or a
+         * response). This results in total 256 different commands.
+         *
+         * The range is divided in two half's, commands between 1-127 are queries and commands between
+         * 128-255 are responses. The commands specified to date are the following. Note this is the value in
+         * DB1, not the actual CMD bit.
+         *
+         * There are some things to think about for this to work properly. The sending node can not use an
+         * higher address range than the receiving node. This is not a problem if the receiving nodes that are
+         * implementing this feature are capable to handle all the address range (i.e. 1-16 777 215). Another
+         * solution is to assign all masters in the network (in a master/slave network) to the low address range
+         * (i.e. between 1-255).
          */
-        uint8_t NDB :4;
+        uint8_t CMD :1;
     } fields;
 
     /** @brief Raw Access to HDB2 byte
@@ -292,6 +298,9 @@ union HDB1
  * simplex RF links since it offers the possibility to not only detect but also to correct corrupt
  * data. There are many different "standards" available.
  *
+ * This implementation sends one parity byte per byte from HDB2 to the last data byte, in a trailer
+ * of the same length, and corrects one flipped bit in each nibble (see snap_fec.h).
+ *
  * @sa HDB1::EDM
  */
 #define EDM_FEC ((uint8_t) 6)
@@ -400,7 +409,8 @@ enum snap_states
     kSource,       //!< kSource
     kProtocol,     //!< kProtocol
     kData,         //!< kData
-    kCRC           //!< kCRC
+    kCRC,          //!< kCRC
+    kSkip          //!< kSkip, rest of a packet addressed to another node
 };
 
 #endif
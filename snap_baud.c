@@ -0,0 +1,276 @@
+/**
+ * @file
+ *
+ * @brief S.N.A.P. USART baud rate negotiation
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+//_____  I N C L U D E S _______________________________________________________
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "config.h"
+#include "snap_baud.h"
+#include "snap_task.h"
+#include "modules/scheduler/scheduler.h"
+
+//_____ M A C R O S ____________________________________________________________
+
+/// Milliseconds over which receive errors are counted
+#define SNAP_BAUD_PERIOD        1000
+
+/// Timer 1 ticks in a millisecond
+#define SNAP_BAUD_TICK          Timer1_ticks( 1000UL )
+/// Timer 1 ticks between wake-ups, well below the 16-bit timer period
+#define SNAP_BAUD_WAKE          Timer1_ticks( 16000UL )
+
+#if ( SNAP_BAUD_MAX >= USART_BAUD_COUNT )
+#error SNAP_BAUD_MAX is not a USART_BAUD_xxx rate code
+#endif
+
+//_____ T Y P E S ______________________________________________________________
+
+enum snap_baud_states
+{
+    kBaudSteady,                ///< Counting receive errors
+    kBaudPending,               ///< Waiting for the answer to leave
+    kBaudTrial                  ///< Waiting for a packet at the new rate
+};
+
+//_____ V A R I A B L E S ______________________________________________________
+
+static enum snap_baud_states baud_state;
+/// Rate code in use, or to be used once pending
+static uint8_t baud_code;
+/// Last rate code a packet was received at
+static uint8_t baud_confirmed;
+/// Milliseconds counted from timer 1, see snap_baud_clock()
+static uint16_t baud_ms;
+/// Timer 1 value baud_ms was last advanced at
+static uint16_t baud_stamp;
+/// Millisecond the current state or error count started at
+static uint16_t baud_start;
+/// Receive counter at baud_start: packets in kBaudTrial, errors in kBaudSteady
+static uint32_t baud_count;
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+/**
+ * @brief Failed USART packets and bytes lost so far
+ */
+static uint32_t snap_baud_errors( void )
+{
+    return snap_stat( kStatUart + SNAP_STAT_ERRORS ) + snap_stat( kStatRxOverflows );
+}
+
+/**
+ * @brief Milliseconds elapsed, from the free running timer 1
+ *
+ * Timer 1 wraps every 65 ms, so this is read at least every SNAP_BAUD_WAKE
+ * ticks while a rate is on trial or other than USART_BAUD, see
+ * snap_baud_wake(). Unlike the USB frame counter, it runs without a host.
+ */
+static uint16_t snap_baud_clock( void )
+{
+    uint16_t elapsed;
+    uint16_t ms;
+
+    ATOMIC_BLOCK( ATOMIC_RESTORESTATE )
+    {
+        elapsed = TCNT1 - baud_stamp;
+    }
+    ms = elapsed / SNAP_BAUD_TICK;
+    baud_stamp += ms * SNAP_BAUD_TICK;
+    baud_ms += ms;
+    return baud_ms;
+}
+
+/**
+ * @brief Wake snap_task() up every SNAP_BAUD_WAKE ticks, or stop
+ *
+ * The timers only need to run while a rate is pending, on trial or other
+ * than USART_BAUD; at USART_BAUD, the node keeps sleeping between packets.
+ */
+static void snap_baud_wake( void )
+{
+    bool wake = ( kBaudSteady != baud_state ) || ( USART_BAUD != baud_code );
+
+    ATOMIC_BLOCK( ATOMIC_RESTORESTATE )
+    {
+        if( wake && !( TIMSK1 & ( 1 << OCIE1B ) ) )
+        {
+            OCR1B = TCNT1 + SNAP_BAUD_WAKE;
+            TIFR1 = ( 1 << OCF1B );
+            TIMSK1 |= ( 1 << OCIE1B );
+        }
+        else if( !wake )
+        {
+            TIMSK1 &= ~( 1 << OCIE1B );
+        }
+    }
+}
+
+/**
+ * @brief Wakes snap_task() up to run the baud rate timers
+ */
+ISR(TIMER1_COMPB_vect)
+{
+    OCR1B += SNAP_BAUD_WAKE;
+    Scheduler_post_from_isr( EVENT_SNAP );
+}
+
+/**
+ * @brief Switch to a rate right away and count errors from now on
+ *
+ * @param code  USART_BAUD_xxx
+ */
+static void snap_baud_fall_back( uint8_t code )
+{
+    USART0_SetBaud( USART0_BaudUbrr( code ) );
+    baud_code = code;
+    baud_confirmed = code;
+    baud_state = kBaudSteady;
+    baud_start = snap_baud_clock();
+    baud_count = snap_baud_errors();
+    snap_baud_wake();
+}
+
+/**
+ * @brief Start the USART at USART_BAUD, and timer 1 for the rate timers
+ */
+void snap_baud_init( void )
+{
+    TCCR1A = 0;
+    TCCR1B = TIMER1_CLOCK;
+    ATOMIC_BLOCK( ATOMIC_RESTORESTATE )
+    {
+        baud_stamp = TCNT1;
+        TIMSK1 &= ~( 1 << OCIE1B );
+    }
+    baud_ms = 0;
+
+    USART0_Init( USART0_BaudUbrr( USART_BAUD ) );
+    baud_code = USART_BAUD;
+    baud_confirmed = USART_BAUD;
+    baud_state = kBaudSteady;
+    baud_start = baud_ms;
+    baud_count = snap_baud_errors();
+}
+
+/**
+ * @brief Carry the counts of the rate timers over a clear of the counters
+ *
+ * Called by snap_stat_clear() just before it clears the counters, so that
+ * what was counted since baud_count still counts against the cleared
+ * counter: no error burst nor packet appears from the clear itself.
+ */
+void snap_baud_stat_clear( void )
+{
+    switch( baud_state )
+    {
+        case kBaudTrial :
+            baud_count -= snap_stat( kStatUart + SNAP_STAT_FRAMES );
+            break;
+
+        case kBaudSteady :
+            baud_count -= snap_stat( kStatUart + SNAP_STAT_ERRORS );
+            break;
+
+        default :
+            break;
+    }
+}
+
+/**
+ * @brief Rate in use
+ *
+ * @return USART_BAUD_xxx, the requested rate if a switch is pending
+ */
+uint8_t snap_baud_current( void )
+{
+    return baud_code;
+}
+
+/**
+ * @brief Ask for a rate, to be used once the transmit buffer is sent
+ *
+ * @param code  USART_BAUD_xxx
+ *
+ * @return rate that will be used: code, or the current rate if code is above
+ * SNAP_BAUD_MAX
+ */
+uint8_t snap_baud_request( uint8_t code )
+{
+    if( ( code <= SNAP_BAUD_MAX ) && ( code != baud_code ) )
+    {
+        baud_code = code;
+        baud_state = kBaudPending;
+        snap_baud_wake();
+    }
+    return baud_code;
+}
+
+/**
+ * @brief Switch rates when due
+ *
+ * A pending rate is set once the USART is idle, so that the answer to the
+ * request goes out at the rate the host still listens at. The new rate is
+ * kept once a packet is received at it, or replaced by the last confirmed
+ * rate after SNAP_BAUD_TRIAL ms. Every SNAP_BAUD_PERIOD ms, a rate other
+ * than USART_BAUD with more than SNAP_BAUD_MAX_ERRORS receive errors falls
+ * back to USART_BAUD. Time is kept with timer 1, so that the node falls back
+ * without USB as well.
+ */
+void snap_baud_task( void )
+{
+    uint16_t now = snap_baud_clock();
+    uint32_t count;
+
+    switch( baud_state )
+    {
+        case kBaudPending :
+            if( !USART0_TxIdle() )
+                break;
+
+            USART0_SetBaud( USART0_BaudUbrr( baud_code ) );
+            baud_state = kBaudTrial;
+            baud_start = now;
+            baud_count = snap_stat( kStatUart + SNAP_STAT_FRAMES );
+            break;
+
+        case kBaudTrial :
+            if( snap_stat( kStatUart + SNAP_STAT_FRAMES ) != baud_count )
+            {
+                baud_confirmed = baud_code;
+                baud_state = kBaudSteady;
+                baud_start = now;
+                baud_count = snap_baud_errors();
+                snap_baud_wake();
+            }
+            else if( ( uint16_t )( now - baud_start ) >= SNAP_BAUD_TRIAL )
+            {
+                snap_baud_fall_back( baud_confirmed );
+            }
+            break;
+
+        case kBaudSteady :
+            if( ( uint16_t )( now - baud_start ) < SNAP_BAUD_PERIOD )
+                break;
+
+            count = snap_baud_errors();
+            if( ( USART_BAUD != baud_code ) && ( count - baud_count > SNAP_BAUD_MAX_ERRORS ) )
+            {
+                snap_baud_fall_back( USART_BAUD );
+                break;
+            }
+            baud_start = now;
+            baud_count = count;
+            break;
+    }
+}
@@ -0,0 +1,36 @@
+/**
+ * @file
+ *
+ * @brief S.N.A.P. USART baud rate negotiation
+ *
+ * The USART starts at USART_BAUD. The host asks for a faster rate with
+ * SNAP_CMD_BAUD; the node answers at the current rate, switches once the
+ * answer has left, and keeps the new rate only if a packet is received at it
+ * within SNAP_BAUD_TRIAL ms. A rate that later fails more than
+ * SNAP_BAUD_MAX_ERRORS packets per second falls back to USART_BAUD.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+#ifndef _SNAP_BAUD_H_
+#define _SNAP_BAUD_H_
+
+//_____ I N C L U D E S ________________________________________________________
+
+#include <stdint.h>
+#include "conf_snap.h"
+#include "lib_mcu/usart/usart.h"
+
+//_____ D E C L A R A T I O N __________________________________________________
+
+void snap_baud_init( void );
+uint8_t snap_baud_current( void );
+void snap_baud_stat_clear( void );
+uint8_t snap_baud_request( uint8_t code );
+void snap_baud_task( void );
+
+#endif /* _SNAP_BAUD_H_ */
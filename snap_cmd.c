@@ -0,0 +1,146 @@
+/**
+ * @file
+ *
+ * @brief S.N.A.P. command mode
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+//_____  I N C L U D E S _______________________________________________________
+
+#include <stddef.h>
+#include <avr/pgmspace.h>
+#include "config.h"
+#include "hid_event.h"
+#include "snap.h"
+#include "snap_baud.h"
+#include "snap_cmd.h"
+#include "snap_task.h"
+#include "snap_tx.h"
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+/**
+ * @brief Largest HDB1::NDB code whose data bytes fit in a packet buffer
+ */
+static uint8_t snap_cmd_max_ndb( void )
+{
+    uint8_t ndb = NDB_512;
+
+    while( pgm_read_word( &snap_ndb_length[ndb] ) > SNAP_MAX_DATA )
+    {
+        --ndb;
+    }
+    return ndb;
+}
+
+/**
+ * @brief Send a response to a query
+ *
+ * The response goes back on the link of the query, with its error detection
+ * method; snap_tx_end() sends the three copies of an EDM_3TX response.
+ *
+ * @param query     received query
+ * @param data      response data bytes, starting with the response code (DB1)
+ * @param ndb       HDB1::NDB code for the number of data bytes (1-8)
+ */
+static void snap_cmd_respond( const struct snap_packet *query, const uint8_t *data, uint8_t ndb )
+{
+    union HDB2 hdb2;
+    union HDB1 hdb1;
+
+    hdb2.raw = 0;
+    hdb2.fields.DAB = query->hdb2.fields.SAB;
+    hdb2.fields.SAB = query->hdb2.fields.DAB;
+    hdb1.raw = 0;
+    hdb1.fields.CMD = 1;
+    hdb1.fields.EDM = query->hdb1.fields.EDM;
+    hdb1.fields.NDB = ndb;
+
+    if( snap_tx_begin( query->link, hdb2.raw, hdb1.raw, query->src, query->dest, NULL ) )
+    {
+        snap_tx_data( data, ndb );
+        snap_tx_end();
+    }
+}
+
+/**
+ * @brief Act upon a received command packet
+ *
+ * Queries are answered; responses are dropped, since this node sends no
+ * query. A response that does not fit in the transmit buffer is not sent;
+ * the querying node will ask again.
+ *
+ * Takes ownership of the packet, like process_packet().
+ *
+ * @param packet    valid packet with HDB1::CMD set
+ */
+void snap_cmd( struct snap_packet *packet )
+{
+    uint8_t response[5];
+    union HDB2 formats;
+    uint16_t frame;
+    uint8_t ndb = NDB_1;
+
+    if( ( 0 == packet->length ) || ( packet->data[0] >= SNAP_CMD_RESPONSE ) )
+    {
+        snap_packet_release( packet );
+        return;
+    }
+
+    response[0] = packet->data[0] | SNAP_CMD_RESPONSE;
+    switch( packet->data[0] )
+    {
+        case SNAP_CMD_PING :
+            break;
+
+        case SNAP_CMD_CAPS :
+            formats.fields.DAB = DAB_3;
+            formats.fields.SAB = SAB_3;
+            formats.fields.PFB = PFB_3;
+            formats.fields.ACK = ACK_REQ;
+            response[1] = snap_edm_supported;
+            response[2] = snap_cmd_max_ndb();
+            response[3] = formats.raw;
+            response[4] = SNAP_WINDOW_SIZE;
+            ndb = NDB_5;
+            break;
+
+        case SNAP_CMD_FRAME :
+            frame = hid_event_frame();
+            response[1] = ( uint8_t )( frame >> 8 );
+            response[2] = ( uint8_t )frame;
+            ndb = NDB_3;
+            break;
+
+        case SNAP_CMD_BAUD :
+            if( kSnapUart != packet->link )
+            {
+                // The rate of the USART is only negotiated on the USART
+                response[0] = SNAP_CMD_UNSUPPORTED;
+                response[1] = packet->data[0];
+                ndb = NDB_2;
+                break;
+            }
+            if( packet->length > 1 )
+                response[1] = snap_baud_request( packet->data[1] );
+            else
+                response[1] = snap_baud_current();
+            response[2] = SNAP_BAUD_MAX;
+            ndb = NDB_3;
+            break;
+
+        default :
+            response[0] = SNAP_CMD_UNSUPPORTED;
+            response[1] = packet->data[0];
+            ndb = NDB_2;
+            break;
+    }
+
+    snap_cmd_respond( packet, response, ndb );
+    snap_packet_release( packet );
+}
@@ -0,0 +1,87 @@
+/**
+ * @file
+ *
+ * @brief S.N.A.P. command mode
+ *
+ * A packet with HDB1::CMD set carries a command in DB1, its first data byte.
+ * Commands 1-127 are queries; the answer to query q is the response q | 0x80,
+ * sent back to the source of the query with the same error detection method,
+ * in three copies for a query sent with EDM_3TX.
+ * A query this node does not know is answered with SNAP_CMD_UNSUPPORTED.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+#ifndef _SNAP_CMD_H_
+#define _SNAP_CMD_H_
+
+//_____ I N C L U D E S ________________________________________________________
+
+#include <stdint.h>
+#include "snap_pool.h"
+
+//_____ M A C R O S ____________________________________________________________
+
+/// Commands from this value up are responses
+#define SNAP_CMD_RESPONSE       ( ( uint8_t ) 0x80 )
+
+/** @brief Response to an unknown query
+ *
+ * DB2 holds the query.
+ */
+#define SNAP_CMD_UNSUPPORTED    ( ( uint8_t ) 0x80 )
+
+/** @brief Query: is the node there
+ *
+ * Answered with SNAP_CMD_PING | SNAP_CMD_RESPONSE and no other data byte.
+ */
+#define SNAP_CMD_PING           ( ( uint8_t ) 0x01 )
+
+/** @brief Query: which packet formats does the node receive
+ *
+ * Answered with SNAP_CMD_CAPS | SNAP_CMD_RESPONSE followed by:
+ *
+ * <PRE>
+ * DB2  HDB1::EDM codes received, bit n set for code n
+ * DB3  largest HDB1::NDB code received
+ * DB4  largest HDB2::DAB, SAB and PFB received, in their HDB2 positions;
+ *      HDB2::ACK is ACK_REQ since ACK requests are answered
+ * DB5  number of sequenced packets that may be in flight (sliding window)
+ * </PRE>
+ */
+#define SNAP_CMD_CAPS           ( ( uint8_t ) 0x02 )
+
+/** @brief Query: current frame number of timed HID events
+ *
+ * Answered with SNAP_CMD_FRAME | SNAP_CMD_RESPONSE followed by the frame
+ * number, most significant byte first (DB2-DB3). See hid_event.h.
+ */
+#define SNAP_CMD_FRAME          ( ( uint8_t ) 0x03 )
+
+/** @brief Query: change the USART baud rate
+ *
+ * DB2 holds the rate code asked for, USART_BAUD_xxx. Answered at the current
+ * rate with SNAP_CMD_BAUD | SNAP_CMD_RESPONSE followed by:
+ *
+ * <PRE>
+ * DB2  rate code used from now on: the one asked for, or the current one if
+ *      it is above DB3
+ * DB3  fastest rate code supported, SNAP_BAUD_MAX
+ * </PRE>
+ *
+ * The node switches once the answer has been sent, and switches back unless
+ * it receives a packet at the new rate within SNAP_BAUD_TRIAL ms, timed by
+ * the node itself whether or not USB is connected. A query without DB2 reads
+ * the current rate. Only supported on the USART. See snap_baud.h.
+ */
+#define SNAP_CMD_BAUD           ( ( uint8_t ) 0x04 )
+
+//_____ D E C L A R A T I O N __________________________________________________
+
+void snap_cmd( struct snap_packet *packet );
+
+#endif /* _SNAP_CMD_H_ */
@@ -0,0 +1,54 @@
+/**
+ * @file
+ *
+ * @brief S.N.A.P. CRC lookup tables
+ *
+ * The tables are computed by the preprocessor from the polynomials given in
+ * snap.h, so they are generated by each build and placed in flash.
+ *
+ * - 8-bit CRC:  X^8+X^5+X^4+1, processed LSB first (reflected polynomial 0x8C)
+ * - 16-bit CRC: X^16+X^12+X^5+1, processed MSB first (polynomial 0x1021)
+ * - 32-bit CRC: 0x04C11DB7, processed LSB first (reflected polynomial 0xEDB88320)
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+//_____  I N C L U D E S _______________________________________________________
+
+#include "snap_crc.h"
+
+//_____ M A C R O S ____________________________________________________________
+
+/// One bit of the reflected 8-bit CRC
+#define CRC8_BIT(c)     ( ( ( c ) >> 1 ) ^ ( ( 0U - ( ( c ) & 1U ) ) & 0x8CU ) )
+/// One bit of the 16-bit CRC
+#define CRC16_BIT(c)    ( ( ( ( c ) << 1 ) & 0xFFFFU ) ^ ( ( 0U - ( ( ( c ) >> 15 ) & 1U ) ) & 0x1021U ) )
+/// One bit of the reflected 32-bit CRC
+#define CRC32_BIT(c)    ( ( ( c ) >> 1 ) ^ ( ( 0UL - ( ( c ) & 1UL ) ) & 0xEDB88320UL ) )
+
+/// Eight bits of a CRC
+#define CRC_BYTE(b, c)  b( b( b( b( b( b( b( b( c ) ) ) ) ) ) ) )
+
+/// Table entries
+#define CRC8_ENTRY(i)   ( ( uint8_t )CRC_BYTE( CRC8_BIT, ( i ) & 0xFFU ) )
+#define CRC16_ENTRY(i)  ( ( uint16_t )CRC_BYTE( CRC16_BIT, ( ( i ) & 0xFFU ) << 8 ) )
+#define CRC32_ENTRY(i)  ( ( uint32_t )CRC_BYTE( CRC32_BIT, ( i ) & 0xFFUL ) )
+
+/// Expand a table entry macro for every byte value
+#define CRC_TABLE_4(e, i)   e( i ), e( i + 1 ), e( i + 2 ), e( i + 3 )
+#define CRC_TABLE_16(e, i)  CRC_TABLE_4( e, i ), CRC_TABLE_4( e, i + 4 ), \
+                            CRC_TABLE_4( e, i + 8 ), CRC_TABLE_4( e, i + 12 )
+#define CRC_TABLE_64(e, i)  CRC_TABLE_16( e, i ), CRC_TABLE_16( e, i + 16 ), \
+                            CRC_TABLE_16( e, i + 32 ), CRC_TABLE_16( e, i + 48 )
+#define CRC_TABLE(e)        CRC_TABLE_64( e, 0 ), CRC_TABLE_64( e, 64 ), \
+                            CRC_TABLE_64( e, 128 ), CRC_TABLE_64( e, 192 )
+
+//_____ V A R I A B L E S ______________________________________________________
+
+const uint8_t snap_crc8_table[256] PROGMEM = { CRC_TABLE( CRC8_ENTRY ) };
+const uint16_t snap_crc16_table[256] PROGMEM = { CRC_TABLE( CRC16_ENTRY ) };
+const uint32_t snap_crc32_table[256] PROGMEM = { CRC_TABLE( CRC32_ENTRY ) };
@@ -0,0 +1,86 @@
+/**
+ * @file
+ *
+ * @brief S.N.A.P. error detection methods
+ *
+ * Checksums are updated one byte at a time as the packet is received or
+ * transmitted, using 256 entry tables held in flash.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+#ifndef _SNAP_CRC_H_
+#define _SNAP_CRC_H_
+
+//_____ I N C L U D E S ________________________________________________________
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "snap.h"
+
+//_____ D E F I N I T I O N ____________________________________________________
+
+extern const uint8_t snap_crc8_table[256] PROGMEM;
+extern const uint16_t snap_crc16_table[256] PROGMEM;
+extern const uint32_t snap_crc32_table[256] PROGMEM;
+
+//_____ D E C L A R A T I O N __________________________________________________
+
+/**
+ * @brief Initial value of the checksum register for an error detection method
+ *
+ * @param edm   HDB1::EDM code
+ */
+static inline uint32_t snap_crc_init( uint8_t edm )
+{
+    return ( EDM_CRC32 == edm ) ? 0xFFFFFFFFUL : 0;
+}
+
+/**
+ * @brief Add one byte to the checksum register
+ *
+ * @param edm   HDB1::EDM code
+ * @param crc   checksum register
+ * @param c     packet byte
+ *
+ * @return updated checksum register, unchanged for methods without a checksum
+ */
+static inline uint32_t snap_crc_update( uint8_t edm, uint32_t crc, uint8_t c )
+{
+    switch( edm )
+    {
+        case EDM_CHKSUM8 :
+            return ( uint8_t )( crc + c );
+
+        case EDM_CRC8 :
+            return pgm_read_byte( &snap_crc8_table[( uint8_t )crc ^ c] );
+
+        case EDM_CRC16 :
+            return ( uint16_t )( crc << 8 ) ^ pgm_read_word( &snap_crc16_table[( uint8_t )( crc >> 8 ) ^ c] );
+
+        case EDM_CRC32 :
+            return ( crc >> 8 ) ^ pgm_read_dword( &snap_crc32_table[( uint8_t )crc ^ c] );
+
+        default :
+            return crc;
+    }
+}
+
+/**
+ * @brief Value to transmit from the checksum register
+ *
+ * @param edm   HDB1::EDM code
+ * @param crc   checksum register
+ *
+ * @return checksum, sent most significant byte first
+ */
+static inline uint32_t snap_crc_final( uint8_t edm, uint32_t crc )
+{
+    return ( EDM_CRC32 == edm ) ? ~crc : crc;
+}
+
+#endif /* _SNAP_CRC_H_ */
@@ -0,0 +1,110 @@
+/**
+ * @file
+ *
+ * @brief S.N.A.P. forward error correction (EDM_FEC)
+ *
+ * Parity nibble of data nibble d3 d2 d1 d0:
+ *
+ * <PRE>
+ * Bit 0    d0 ^ d1 ^ d3
+ * Bit 1    d0 ^ d2 ^ d3
+ * Bit 2    d1 ^ d2 ^ d3
+ * Bit 3    parity of the other seven bits
+ * </PRE>
+ *
+ * The syndrome of a nibble is its received parity XORed with the parity
+ * computed again. A single flipped data bit gives the parity of that bit
+ * alone, a syndrome of weight 3; a single flipped parity bit gives a syndrome
+ * of weight 1. Any two flipped bits give a non-zero syndrome of even weight.
+ *
+ * The code only reads its tables from flash: test/fec_bench.c builds it on a
+ * host with a stand-in for avr/pgmspace.h, checks it and times it.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+//_____  I N C L U D E S _______________________________________________________
+
+#include "snap_fec.h"
+
+//_____ V A R I A B L E S ______________________________________________________
+
+/// Parity nibble of each data nibble
+const uint8_t snap_fec_parity_table[16] PROGMEM =
+{
+    0x0, 0xB, 0xD, 0x6, 0xE, 0x5, 0x3, 0x8,
+    0x7, 0xC, 0xA, 0x1, 0x9, 0x2, 0x4, 0xF
+};
+
+/// Data bits to flip for each syndrome, or SNAP_FEC_UNCORRECTABLE
+const uint8_t snap_fec_fix_table[16] PROGMEM =
+{
+    0x0,                        // No error
+    0x0,                        // Parity bit 0
+    0x0,                        // Parity bit 1
+    SNAP_FEC_UNCORRECTABLE,
+    0x0,                        // Parity bit 2
+    SNAP_FEC_UNCORRECTABLE,
+    SNAP_FEC_UNCORRECTABLE,
+    0x8,                        // Data bit 3
+    0x0,                        // Parity bit 3
+    SNAP_FEC_UNCORRECTABLE,
+    SNAP_FEC_UNCORRECTABLE,
+    0x1,                        // Data bit 0
+    SNAP_FEC_UNCORRECTABLE,
+    0x2,                        // Data bit 1
+    0x4,                        // Data bit 2
+    SNAP_FEC_UNCORRECTABLE
+};
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+/**
+ * @brief Correct packet bytes in place from their parity bytes
+ *
+ * The syndromes are all checked before any byte is corrected, so that the
+ * bytes of a packet that cannot be corrected are left as received.
+ *
+ * @param p         first protected byte (HDB2)
+ * @param n         number of protected bytes
+ * @param parity    parity bytes, one per protected byte
+ *
+ * @return false if a nibble has more than one flipped bit
+ */
+bool snap_fec_decode( uint8_t *p, uint16_t n, const uint8_t *parity )
+{
+    uint16_t i;
+    uint8_t syndrome;
+    uint8_t hi;
+    uint8_t lo;
+    bool dirty = false;
+
+    for( i = 0; i < n; ++i )
+    {
+        syndrome = snap_fec_parity( p[i] ) ^ parity[i];
+        if( syndrome )
+        {
+            hi = pgm_read_byte( &snap_fec_fix_table[syndrome >> 4] );
+            lo = pgm_read_byte( &snap_fec_fix_table[syndrome & 0x0F] );
+            if( ( hi | lo ) & SNAP_FEC_UNCORRECTABLE )
+                return false;
+            dirty = true;
+        }
+    }
+
+    for( i = 0; dirty && ( i < n ); ++i )
+    {
+        syndrome = snap_fec_parity( p[i] ) ^ parity[i];
+        if( syndrome )
+        {
+            hi = pgm_read_byte( &snap_fec_fix_table[syndrome >> 4] );
+            lo = pgm_read_byte( &snap_fec_fix_table[syndrome & 0x0F] );
+            p[i] ^= ( hi << 4 ) | lo;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file
+ *
+ * @brief S.N.A.P. forward error correction (EDM_FEC)
+ *
+ * Each byte following SYNC, up to the last data byte, is protected by one
+ * parity byte sent in the trailer, in the same order. Each nibble is coded
+ * with an extended Hamming (8,4) code: the parity nibble holds three Hamming
+ * bits and an overall parity bit. One flipped bit per nibble is corrected,
+ * two are detected.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+#ifndef _SNAP_FEC_H_
+#define _SNAP_FEC_H_
+
+//_____ I N C L U D E S ________________________________________________________
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "snap.h"
+
+//_____ M A C R O S ____________________________________________________________
+
+/// Marks an uncorrectable syndrome in snap_fec_fix_table
+#define SNAP_FEC_UNCORRECTABLE  0x80
+
+//_____ D E F I N I T I O N ____________________________________________________
+
+extern const uint8_t snap_fec_parity_table[16] PROGMEM;
+extern const uint8_t snap_fec_fix_table[16] PROGMEM;
+
+//_____ D E C L A R A T I O N __________________________________________________
+
+/**
+ * @brief Number of bytes protected in a packet, which is also the trailer length
+ *
+ * @param hdb2      Header Definition Byte 2
+ * @param length    number of data bytes
+ */
+static inline uint16_t snap_fec_size( union HDB2 hdb2, uint16_t length )
+{
+    return 2 + hdb2.fields.DAB + hdb2.fields.SAB + hdb2.fields.PFB + length;
+}
+
+/**
+ * @brief Parity byte of a packet byte
+ *
+ * @param c     packet byte
+ */
+static inline uint8_t snap_fec_parity( uint8_t c )
+{
+    return ( pgm_read_byte( &snap_fec_parity_table[c >> 4] ) << 4 ) |
+           pgm_read_byte( &snap_fec_parity_table[c & 0x0F] );
+}
+
+bool snap_fec_decode( uint8_t *p, uint16_t n, const uint8_t *parity );
+
+#endif /* _SNAP_FEC_H_ */
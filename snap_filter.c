@@ -0,0 +1,106 @@
+/**
+ * @file
+ *
+ * @brief S.N.A.P. destination address filter
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+//_____  I N C L U D E S _______________________________________________________
+
+#include <util/atomic.h>
+#include "snap_filter.h"
+
+//_____ M A C R O S ____________________________________________________________
+
+#if ( SNAP_FILTER_SIZE < 1 )
+#error SNAP_FILTER_SIZE must leave room for SNAP_NODE_ADDRESS
+#endif
+
+//_____ V A R I A B L E S ______________________________________________________
+
+/// Addresses received, filter[0] being SNAP_NODE_ADDRESS
+static uint32_t filter[SNAP_FILTER_SIZE];
+
+/// Number of addresses in filter
+static volatile uint8_t filter_count;
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+/**
+ * @brief Receive packets for SNAP_NODE_ADDRESS only
+ */
+void snap_filter_init( void )
+{
+    filter[0] = SNAP_NODE_ADDRESS;
+    filter_count = 1;
+}
+
+/**
+ * @brief Receive packets sent to a group address as well
+ *
+ * @param address   group address
+ *
+ * @return false if the filter is full
+ */
+bool snap_filter_add( uint32_t address )
+{
+    if( snap_filter_match( address ) )
+        return true;
+    if( SNAP_FILTER_SIZE == filter_count )
+        return false;
+
+    ATOMIC_BLOCK( ATOMIC_RESTORESTATE )
+    {
+        filter[filter_count++] = address;
+    }
+    return true;
+}
+
+/**
+ * @brief Stop receiving packets sent to a group address
+ *
+ * @param address   group address added with snap_filter_add()
+ */
+void snap_filter_remove( uint32_t address )
+{
+    uint8_t i;
+
+    ATOMIC_BLOCK( ATOMIC_RESTORESTATE )
+    {
+        for( i = 1; i < filter_count; ++i )
+        {
+            if( filter[i] == address )
+            {
+                filter[i] = filter[--filter_count];
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Check whether packets sent to an address are for this node
+ *
+ * May be called from an interrupt handler.
+ *
+ * @param address   destination address
+ */
+bool snap_filter_match( uint32_t address )
+{
+    uint8_t i;
+
+    if( SNAP_BROADCAST == address )
+        return true;
+
+    for( i = 0; i < filter_count; ++i )
+    {
+        if( filter[i] == address )
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,42 @@
+/**
+ * @file
+ *
+ * @brief S.N.A.P. destination address filter
+ *
+ * The receiver checks the destination address of each packet as soon as its
+ * last byte has arrived. Packets for other nodes are skipped by byte count,
+ * without being stored or checked.
+ *
+ * The filter holds the unicast address of this node, SNAP_NODE_ADDRESS, and
+ * any group address added with snap_filter_add(). Packets sent to
+ * SNAP_BROADCAST, or without a destination address, are always received.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+#ifndef _SNAP_FILTER_H_
+#define _SNAP_FILTER_H_
+
+//_____ I N C L U D E S ________________________________________________________
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "conf_snap.h"
+
+//_____ M A C R O S ____________________________________________________________
+
+/// Destination address of packets for every node
+#define SNAP_BROADCAST          ( ( uint32_t ) 0 )
+
+//_____ D E C L A R A T I O N __________________________________________________
+
+void snap_filter_init( void );
+bool snap_filter_add( uint32_t address );
+void snap_filter_remove( uint32_t address );
+bool snap_filter_match( uint32_t address );
+
+#endif /* _SNAP_FILTER_H_ */
@@ -0,0 +1,125 @@
+/**
+ * @file
+ *
+ * @brief Pool of S.N.A.P. packet buffers
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+//_____  I N C L U D E S _______________________________________________________
+
+#include <stddef.h>
+#include <util/atomic.h>
+#include "snap_pool.h"
+
+//_____ M A C R O S ____________________________________________________________
+
+#if ( SNAP_POOL_SIZE > 16 )
+#error SNAP_POOL_SIZE must not exceed 16
+#endif
+
+#if ( SNAP_POOL_BYTES > SNAP_POOL_MAX_BYTES )
+#error The pool takes more than SNAP_POOL_MAX_BYTES of SRAM: shrink SNAP_POOL_SIZE, SNAP_MAX_DATA or drop SNAP_FEC_SUPPORT
+#endif
+
+//_____ V A R I A B L E S ______________________________________________________
+
+static struct snap_packet pool[SNAP_POOL_SIZE];
+
+/// One bit per free buffer
+static volatile uint16_t pool_free;
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+/**
+ * @brief Read a big-endian address
+ *
+ * @param p     first address byte
+ * @param n     number of address bytes (0-3)
+ *
+ * @return address
+ */
+uint32_t snap_address( const uint8_t *p, uint8_t n )
+{
+    uint32_t address = 0;
+
+    while( n-- )
+    {
+        address = ( address << 8 ) | *p++;
+    }
+    return address;
+}
+
+/**
+ * @brief Return every buffer to the pool
+ */
+void snap_pool_init( void )
+{
+    pool_free = ( uint16_t )( ( 1UL << SNAP_POOL_SIZE ) - 1 );
+}
+
+/**
+ * @brief Take a buffer from the pool
+ *
+ * May be called from an interrupt handler.
+ *
+ * @return buffer, or NULL if the pool is empty
+ */
+struct snap_packet *snap_packet_alloc( void )
+{
+    struct snap_packet *packet = NULL;
+    uint16_t mask = 1;
+    uint8_t i;
+
+    ATOMIC_BLOCK( ATOMIC_RESTORESTATE )
+    {
+        for( i = 0; i < SNAP_POOL_SIZE; ++i, mask <<= 1 )
+        {
+            if( pool_free & mask )
+            {
+                pool_free &= ~mask;
+                packet = &pool[i];
+                break;
+            }
+        }
+    }
+    return packet;
+}
+
+/**
+ * @brief Fill in the addresses and field pointers of a packet descriptor
+ *
+ * @param packet    packet whose hdb2 and raw members are set
+ */
+void snap_packet_decode( struct snap_packet *packet )
+{
+    uint8_t *p = &packet->raw[2];
+    uint8_t dab = packet->hdb2.fields.DAB;
+    uint8_t sab = packet->hdb2.fields.SAB;
+
+    packet->dest = snap_address( p, dab );
+    p += dab;
+    packet->src = snap_address( p, sab );
+    p += sab;
+    packet->flags = p;
+    packet->data = p + packet->hdb2.fields.PFB;
+}
+
+/**
+ * @brief Return a buffer to the pool
+ *
+ * @param packet    buffer obtained from snap_packet_alloc()
+ */
+void snap_packet_release( struct snap_packet *packet )
+{
+    uint16_t mask = 1 << ( packet - pool );
+
+    ATOMIC_BLOCK( ATOMIC_RESTORESTATE )
+    {
+        pool_free |= mask;
+    }
+}
@@ -0,0 +1,107 @@
+/**
+ * @file
+ *
+ * @brief Pool of S.N.A.P. packet buffers
+ *
+ * Packets are received in place into buffers taken from a static pool. The
+ * buffer is then handed to its consumer as is, which returns it to the pool
+ * with snap_packet_release() once done, so payload bytes are never copied.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+#ifndef _SNAP_POOL_H_
+#define _SNAP_POOL_H_
+
+//_____ I N C L U D E S ________________________________________________________
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "conf_snap.h"
+#include "snap.h"
+
+//_____ M A C R O S ____________________________________________________________
+
+#if (SNAP_USB_TUNNEL == true)
+/// Number of links packets are received from, see enum snap_link
+#define SNAP_LINKS              2
+#else
+#define SNAP_LINKS              1
+#endif
+
+/// Largest header following the SYNC byte: HDB2, HDB1, 3 DAB, 3 SAB and 3 PFB
+#define SNAP_HEADER_SIZE        ( 2 + 3 + 3 + 3 )
+
+#if (SNAP_FEC_SUPPORT == true)
+/// Largest error detection trailer: one FEC parity byte per header and data byte
+#define SNAP_EDM_SIZE           ( SNAP_HEADER_SIZE + SNAP_MAX_DATA )
+#else
+/// Largest error detection trailer (32-bit CRC)
+#define SNAP_EDM_SIZE           4
+#endif
+
+/// Largest packet stored in a buffer, SYNC excluded
+#define SNAP_FRAME_SIZE         ( SNAP_HEADER_SIZE + SNAP_MAX_DATA + SNAP_EDM_SIZE )
+
+/// Bytes of a struct snap_packet beside its raw buffer, on the AVR
+#define SNAP_PACKET_DECODED     20
+
+/// SRAM taken by the pool: 2720 bytes with FEC, 1584 without
+#define SNAP_POOL_BYTES         ( SNAP_POOL_SIZE * ( SNAP_FRAME_SIZE + SNAP_PACKET_DECODED ) )
+
+//_____ T Y P E S ______________________________________________________________
+
+/**
+ * @brief Links packets are received from and answered on
+ */
+enum snap_link
+{
+    kSnapUart,                  ///< USART
+    kSnapUsb                    ///< HID endpoints, see SNAP_USB_TUNNEL
+};
+
+/**
+ * @brief S.N.A.P. packet descriptor and buffer
+ *
+ * The packet is stored in wire order in @ref raw; the remaining members are
+ * decoded from it once the last byte has been received and point into it.
+ */
+struct snap_packet
+{
+    /// Header Definition Byte 2
+    union HDB2 hdb2;
+    /// Header Definition Byte 1
+    union HDB1 hdb1;
+    /// Destination address
+    uint32_t dest;
+    /// Source address
+    uint32_t src;
+    /// Protocol specific flag bytes, HDB2::PFB bytes long
+    uint8_t *flags;
+    /// Data bytes, @ref length bytes long
+    uint8_t *data;
+    /// Number of data bytes
+    uint16_t length;
+    /// Number of bytes stored in @ref raw
+    uint16_t size;
+    /// Packet passed error detection
+    bool valid;
+    /// Link the packet was received from, enum snap_link
+    uint8_t link;
+    /// Packet as received, starting with HDB2
+    uint8_t raw[SNAP_FRAME_SIZE];
+};
+
+//_____ D E C L A R A T I O N __________________________________________________
+
+void snap_pool_init( void );
+struct snap_packet *snap_packet_alloc( void );
+void snap_packet_decode( struct snap_packet *packet );
+void snap_packet_release( struct snap_packet *packet );
+uint32_t snap_address( const uint8_t *p, uint8_t n );
+
+#endif /* _SNAP_POOL_H_ */
@@ -3,6 +3,21 @@
  *
  * @brief This file manages a S.N.A.P. protocol implementation.
  *
+ * The receiver is a table driven state machine. Once both header definition
+ * bytes are known, the length of every remaining field is looked up and the
+ * non-empty fields are queued in a plan. Each following byte then costs one
+ * store, one decrement and, at the end of a field, one step through the plan,
+ * regardless of the packet layout.
+ *
+ * When a packet is rejected, the bytes received after its SYNC byte are
+ * searched for the next SYNC byte followed by a plausible header, and
+ * received again from there. A SYNC byte inside the data of a packet whose
+ * start was lost only costs the bytes up to the real start of the next one.
+ *
+ * Packets for other nodes are recognized at the end of their destination
+ * address and skipped by byte count, without storing or checking them.
+ * Packets with FEC are only filtered once corrected.
+ *
  * @author               Andrew Cooper
  *
  *
@@ -14,118 +29,702 @@
 
 //_____  I N C L U D E S _______________________________________________________
 
-
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+#include "config.h"
+#include "hid_event.h"
 #include "snap.h"
+#include "snap_baud.h"
+#include "snap_cmd.h"
+#include "snap_crc.h"
+#include "snap_fec.h"
+#include "snap_filter.h"
+#include "snap_pool.h"
+#include "snap_task.h"
+#include "snap_tx.h"
+#include "snap_usb.h"
+#include "snap_vote.h"
+#include "snap_window.h"
 #include "lib_mcu/usart/usart.h"
 
 //_____ M A C R O S ____________________________________________________________
 
+/// Number of fields following the header definition bytes
+#define SNAP_PLAN_SIZE          5
+
+#define SNAP_POOL_MASK          ( SNAP_POOL_SIZE - 1 )
+#if ( SNAP_POOL_SIZE & SNAP_POOL_MASK )
+#error SNAP_POOL_SIZE is not a power of 2
+#endif
+
+/**
+ * Append a field to the receive plan if it is not empty
+ */
+#define Snap_plan(rx, n, s, l)  if( 0 != ( l ) ) \
+                                { \
+                                    ( rx )->plan_state[n] = ( s ); \
+                                    ( rx )->plan_len[n] = ( l ); \
+                                    ++( n ); \
+                                }
+
+//_____ T Y P E S ______________________________________________________________
+
+/**
+ * @brief Receiver state for one S.N.A.P. link
+ */
+struct snap_rx
+{
+    /// Field currently being received
+    enum snap_states state;
+    /// Next free byte in the packet buffer
+    uint8_t *dst;
+    /// Bytes left in the current field
+    uint16_t left;
+    /// Index of the current field in the plan
+    uint8_t stage;
+    /// Error detection method of the current packet
+    uint8_t edm;
+    /// Checksum register of the current packet
+    uint32_t crc;
+    /// Fields of the current packet, in order, terminated by kSnapSync
+    uint8_t plan_state[SNAP_PLAN_SIZE + 1];
+    /// Length of each field of the plan, terminated by 0
+    uint16_t plan_len[SNAP_PLAN_SIZE + 1];
+    /// Packet being received, NULL until the next SYNC byte
+    struct snap_packet *packet;
+    /// Bytes of a rejected packet left in its buffer to be searched again, 0 if none
+    uint16_t rescan;
+    /// The packet being received was found in the bytes of a rejected packet
+    bool replay;
+    /// First counter of the receiver in snap_stats
+    uint8_t stats;
+    /// Link the packets arrive on, see enum snap_link
+    uint8_t link;
+};
 
 //_____ V A R I A B L E S ______________________________________________________
 
-static enum snap_states state;
+/// Number of data bytes for each HDB1::NDB code, 0 for unsupported codes
+const uint16_t snap_ndb_length[16] PROGMEM =
+{
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 16, 32, 64, 128, 256, 512, 0
+};
 
-static union HDB2 hdb2;
-static union HDB1 hdb1;
-static short hdb_cnt;
-static short dab_cnt;
-static short sab_cnt;
-static short pfb_cnt;
-static short db_cnt;
-static short crc_cnt;
+/// Number of trailing bytes for each HDB1::EDM code
+const uint8_t snap_edm_length[8] PROGMEM =
+{
+    0, 0, 1, 1, 2, 4, 0, 0
+};
+
+/// Supported HDB1::EDM codes that check the packet, one bit per code
+static const uint8_t edm_checked = ( 1 << EDM_CHKSUM8 ) |
+                                   ( 1 << EDM_CRC8 ) |
+                                   ( 1 << EDM_CRC16 ) |
+                                   ( 1 << EDM_CRC32 )
+#if (SNAP_FEC_SUPPORT == true)
+                                 | ( 1 << EDM_FEC )
+#endif
+                                 ;
+
+/// Supported HDB1::EDM codes, one bit per code
+const uint8_t snap_edm_supported = ( 1 << EDM_NONE ) |
+                                   ( 1 << EDM_3TX ) |
+                                   ( 1 << EDM_CHKSUM8 ) |
+                                   ( 1 << EDM_CRC8 ) |
+                                   ( 1 << EDM_CRC16 ) |
+                                   ( 1 << EDM_CRC32 )
+#if (SNAP_FEC_SUPPORT == true)
+                                 | ( 1 << EDM_FEC )
+#endif
+                                 ;
+
+/// Complete packets waiting for snap_task(), from tail to head
+static struct snap_packet *rx_queue[SNAP_POOL_SIZE];
+static volatile uint8_t rx_queue_head;
+static volatile uint8_t rx_queue_tail;
+
+volatile uint32_t snap_stats[kStatRxOverflows];
+
+static struct snap_rx uart_rx;
+#if (SNAP_USB_TUNNEL == true)
+static struct snap_rx usb_rx;
+#endif
 
 //_____ D E F I N I T I O N S __________________________________________________
 
-void process_packet( void );
+/**
+ * @brief Restart a receiver, waiting for the next SYNC byte
+ *
+ * The receiver keeps its packet buffer, if any, for the next packet.
+ *
+ * @param rx    receiver
+ */
+static void snap_rx_reset( struct snap_rx *rx )
+{
+    rx->state = kSnapSync;
+}
 
 /**
- * @brief Initialize S.N.A.P processing task
+ * @brief Restart a receiver after a rejected packet
+ *
+ * The bytes stored so far are kept for snap_rx_rescan().
+ *
+ * @param rx    receiver
  */
-void snap_task_init( void )
+static void snap_rx_reject( struct snap_rx *rx )
+{
+    rx->rescan = rx->dst - rx->packet->raw;
+    snap_rx_reset( rx );
+}
+
+/**
+ * @brief Skip the rest of a packet addressed to another node
+ *
+ * @param rx    receiver, positioned after the last byte of the destination address
+ */
+static void snap_rx_skip( struct snap_rx *rx )
+{
+    uint16_t left = 0;
+    uint8_t stage;
+
+    for( stage = rx->stage + 1; 0 != rx->plan_len[stage]; ++stage )
+    {
+        left += rx->plan_len[stage];
+    }
+
+    rx->state = kSkip;
+    rx->left = left;
+    if( 0 == left )
+    {
+        snap_rx_reset( rx );
+    }
+}
+
+/**
+ * @brief Check that a header definition byte describes a packet that can be received
+ *
+ * @param hdb1  Header Definition Byte 1
+ * @param edm   accepted HDB1::EDM codes, one bit per code
+ */
+static bool snap_rx_supported( union HDB1 hdb1, uint8_t edm )
 {
+    uint8_t ndb = hdb1.fields.NDB;
 
+    return ( NDB_USER != ndb ) &&
+           ( SNAP_MAX_DATA >= pgm_read_word( &snap_ndb_length[ndb] ) ) &&
+           ( 0 != ( edm & ( 1 << hdb1.fields.EDM ) ) );
 }
 
 /**
- * @brief
+ * @brief Build the receive plan from the header definition bytes
+ *
+ * @param rx    receiver
+ *
+ * @return false if the packet cannot be received
  */
-void snap_task( void )
+static bool snap_rx_plan( struct snap_rx *rx )
 {
-    unsigned char frame;
+    struct snap_packet *packet = rx->packet;
+    uint8_t n = 0;
+    uint8_t ndb;
+    uint8_t edm;
+    uint16_t trailer;
+
+    packet->hdb2.raw = packet->raw[0];
+    packet->hdb1.raw = packet->raw[1];
+    ndb = packet->hdb1.fields.NDB;
+    edm = packet->hdb1.fields.EDM;
+
+    if( !snap_rx_supported( packet->hdb1, snap_edm_supported ) )
+        return false;
+    packet->length = pgm_read_word( &snap_ndb_length[ndb] );
 
-    if( USART0_RTR() )
+    Snap_plan( rx, n, kDestination, packet->hdb2.fields.DAB );
+    Snap_plan( rx, n, kSource, packet->hdb2.fields.SAB );
+    Snap_plan( rx, n, kProtocol, packet->hdb2.fields.PFB );
+    Snap_plan( rx, n, kData, packet->length );
+    trailer = pgm_read_byte( &snap_edm_length[edm] );
+#if (SNAP_FEC_SUPPORT == true)
+    if( EDM_FEC == edm )
     {
-        frame = USART0_Receive();
+        trailer = snap_fec_size( packet->hdb2, packet->length );
+    }
+#endif
+    Snap_plan( rx, n, kCRC, trailer );
+    rx->plan_state[n] = kSnapSync;
+    rx->plan_len[n] = 0;
 
-        switch( state )
-        {
-            case kSnapPreamble :
-            case kSnapSync :
-                if( SYNC == frame )
-                {
-                    state = kSnapHeaderDef;
-                    hdb_cnt = 0;
-                }
+    rx->edm = edm;
+    rx->crc = snap_crc_init( edm );
+    rx->crc = snap_crc_update( edm, rx->crc, packet->raw[0] );
+    rx->crc = snap_crc_update( edm, rx->crc, packet->raw[1] );
+
+    rx->stage = 0;
+    rx->state = rx->plan_state[0];
+    rx->left = rx->plan_len[0];
+    return true;
+}
+
+/**
+ * @brief Compare the received error detection bytes with the checksum register
+ *
+ * With forward error correction, the packet is corrected in place instead. A
+ * corrected header definition byte makes the packet invalid, since the rest
+ * of the packet was received according to the corrupted one.
+ *
+ * @param rx    receiver, positioned after the last byte of the packet
+ *
+ * @return true if the packet is valid
+ */
+static bool snap_rx_check( struct snap_rx *rx )
+{
+    uint8_t n = pgm_read_byte( &snap_edm_length[rx->edm] );
+    const uint8_t *p = rx->dst - n;
+    uint32_t received = 0;
+
+#if (SNAP_FEC_SUPPORT == true)
+    struct snap_packet *packet = rx->packet;
+    uint16_t size;
+
+    if( EDM_FEC == rx->edm )
+    {
+        size = ( rx->dst - packet->raw ) / 2;
+        return snap_fec_decode( packet->raw, size, packet->raw + size ) &&
+               ( packet->raw[0] == packet->hdb2.raw ) &&
+               ( packet->raw[1] == packet->hdb1.raw );
+    }
+#endif
+
+    while( n-- )
+    {
+        received = ( received << 8 ) | *p++;
+    }
+    return received == snap_crc_final( rx->edm, rx->crc );
+}
+
+/**
+ * @brief Decode a completely received packet and queue it for snap_task()
+ *
+ * Corrupted packets are only queued when they request an ACK, so that
+ * snap_task() can answer with a NAK, and were not found in the bytes of a
+ * rejected packet, where they more likely start at a SYNC byte inside its
+ * data. Other corrupted packets are rejected. The queue holds as many entries
+ * as there are buffers, so it cannot overflow, and is shared by every
+ * receiver. Queuing a packet wakes snap_task() up, whichever interrupt or task
+ * runs the receiver. The receiver takes a new buffer at the next SYNC byte.
+ *
+ * @param rx    receiver
+ */
+static void snap_rx_complete( struct snap_rx *rx )
+{
+    struct snap_packet *packet = rx->packet;
+
+    packet->valid = snap_rx_check( rx );
+    if( !packet->valid )
+    {
+        Snap_stat_inc( rx->stats + SNAP_STAT_ERRORS );
+    }
+    if( !packet->valid && ( rx->replay || ( ACK_REQ != packet->hdb2.fields.ACK ) ) )
+    {
+        snap_rx_reject( rx );
+        return;
+    }
+    rx->replay = false;
+
+    packet->link = rx->link;
+    packet->size = rx->dst - packet->raw;
+    snap_packet_decode( packet );
+    if( ( EDM_FEC == rx->edm ) && !snap_filter_match( packet->dest ) )
+    {
+        snap_rx_reset( rx );
+        return;
+    }
+
+    ATOMIC_BLOCK( ATOMIC_RESTORESTATE )
+    {
+        rx_queue[rx_queue_head & SNAP_POOL_MASK] = packet;
+        ++rx_queue_head;
+    }
+    Scheduler_post( EVENT_SNAP );
+    if( packet->valid )
+    {
+        // Corrupted packets queued to be answered with a NAK count as errors only
+        Snap_stat_inc( rx->stats + SNAP_STAT_FRAMES );
+    }
+    rx->packet = NULL;
+    snap_rx_reset( rx );
+}
+
+/**
+ * @brief Feed one received byte to a receiver
+ *
+ * @param rx    receiver
+ * @param c     received byte
+ */
+static void snap_rx_byte( struct snap_rx *rx, uint8_t c )
+{
+    switch( rx->state )
+    {
+        case kSnapPreamble :
+        case kSnapSync :
+            if( SYNC != c )
+                break;
+
+            if( NULL == rx->packet )
+            {
+                rx->packet = snap_packet_alloc();
+                if( NULL == rx->packet )
+                    break;
+            }
+            rx->state = kSnapHeaderDef;
+            rx->replay = false;
+            rx->dst = rx->packet->raw;
+            rx->left = 2;
+            break;
+
+        case kSnapHeaderDef :
+            *rx->dst++ = c;
+            if( --rx->left )
+                break;
+
+            if( !snap_rx_plan( rx ) )
+            {
+                snap_rx_reject( rx );
+            }
+            else if( 0 == rx->left )
+            {
+                snap_rx_complete( rx );
+            }
+            break;
+
+        case kDestination :
+        case kSource :
+        case kProtocol :
+        case kData :
+        case kCRC :
+            *rx->dst++ = c;
+            if( kCRC != rx->state )
+            {
+                rx->crc = snap_crc_update( rx->edm, rx->crc, c );
+            }
+            if( --rx->left )
                 break;
-            case kSnapHeaderDef :
-                if( 0 == hdb_cnt )
+
+            if( ( kDestination == rx->state ) &&
+                ( EDM_FEC != rx->edm ) &&
+                !snap_filter_match( snap_address( rx->packet->raw + 2, rx->packet->hdb2.fields.DAB ) ) )
+            {
+                // A packet found by snap_rx_rescan() is likely false: reject
+                // it, so that the bytes it would skip are searched as well
+                if( rx->replay )
                 {
-                    hdb_cnt = 1;
-                    hdb2.raw = frame;
+                    snap_rx_reject( rx );
                 }
                 else
                 {
-                    hdb_cnt = 2;
-                    hdb1.raw = frame;
-                    if( DAB_0 == hdb2.fields.DAB )
-                    {
-                        if( SAB_0 == hdb2.fields.SAB )
-                        {
-                            if( PFB_0 == hdb2.fields.PFB )
-                            {
-                                if( NDB_0 == hdb1.fields.NDB )
-                                {
-                                    if( EDM_NONE == hdb1.fields.NDB )
-                                    {
-                                        process_packet();
-                                    }
-                                    else
-                                    {
-                                        state = kCRC;
-                                    }
-                                }
-                                else
-                                {
-                                    state = kData;
-                                }
-                            }
-                            else
-                            {
-                                state = kProtocol;
-                            }
-                        }
-                        else
-                        {
-                            state = kSource;
-                        }
-                    }
-                    else
-                    {
-                        state = kDestination;
-                    }
-
+                    snap_rx_skip( rx );
                 }
-
-            case kDestination :
-            case kSource :
-            case kProtocol :
-            case kData :
-            case kCRC :
                 break;
+            }
+
+            ++rx->stage;
+            rx->state = rx->plan_state[rx->stage];
+            rx->left = rx->plan_len[rx->stage];
+            if( 0 == rx->left )
+            {
+                snap_rx_complete( rx );
+            }
+            break;
+
+        case kSkip :
+            if( 0 == --rx->left )
+            {
+                snap_rx_reset( rx );
+            }
+            break;
+    }
+}
+
+/**
+ * @brief Receive again the bytes left by a rejected packet
+ *
+ * The bytes are searched for a SYNC byte followed by a supported header
+ * definition byte, or by too few bytes to tell. Only packets with a checksum
+ * or FEC are looked for: without one, any SYNC byte inside the rejected
+ * packet would be taken for the start of a valid packet. The bytes following
+ * it are moved to the start of the buffer and fed to the receiver in place,
+ * each one being stored where it already is. Once that packet is complete,
+ * the bytes left are fed to the receiver as if they had just arrived, so that
+ * the packets following it are received, skipped or answered as usual.
+ * Whenever a packet is rejected, the bytes it stored and the bytes not fed
+ * yet are left to be searched again.
+ *
+ * @param rx    receiver, with rx->rescan bytes left in its packet buffer
+ */
+static void snap_rx_rescan( struct snap_rx *rx )
+{
+    struct snap_packet *packet = rx->packet;
+    uint8_t *raw = packet->raw;
+    uint16_t n = rx->rescan;
+    uint16_t i;
+    union HDB1 hdb1;
+
+    rx->rescan = 0;
+    for( i = 0; i < n; ++i )
+    {
+        if( SYNC != raw[i] )
+            continue;
+        if( i + 2 >= n )
+            break;
+        hdb1.raw = raw[i + 2];
+        if( snap_rx_supported( hdb1, edm_checked ) )
+            break;
+    }
+    if( i >= n )
+        return;
+
+    Snap_stat_inc( rx->stats + SNAP_STAT_RESYNCS );
+    n -= i + 1;
+    memmove( raw, raw + i + 1, n );
+    rx->state = kSnapHeaderDef;
+    rx->dst = raw;
+    rx->left = 2;
+    rx->replay = true;
+    for( i = 0; i < n; )
+    {
+        // Once the replayed packet is queued, raw stays untouched until
+        // snap_task() gets to it, and a new packet is received into another
+        // buffer; otherwise each byte is stored at or before where it is read
+        snap_rx_byte( rx, raw[i++] );
+
+        if( 0 != rx->rescan )
+        {
+            memmove( rx->packet->raw + rx->rescan, raw + i, n - i );
+            rx->rescan += n - i;
+            break;
         }
     }
 }
 
-void process_packet()
+/**
+ * @brief Feed one received byte to a receiver, then receive again the bytes
+ * of any packet it rejected
+ *
+ * @param rx    receiver
+ * @param c     received byte
+ */
+static void snap_rx_feed( struct snap_rx *rx, uint8_t c )
+{
+    Snap_stat_inc( rx->stats + SNAP_STAT_BYTES );
+    snap_rx_byte( rx, c );
+    while( 0 != rx->rescan )
+    {
+        snap_rx_rescan( rx );
+    }
+}
+
+/**
+ * @brief Feed one byte to the USART receiver from the USART receive interrupt
+ *
+ * @param c     received byte
+ */
+void snap_rx_isr( unsigned char c )
 {
+    snap_rx_feed( &uart_rx, c );
+}
+
+#if (SNAP_USB_TUNNEL == true)
+/**
+ * @brief Feed one byte received through the HID OUT endpoint to the USB receiver
+ *
+ * @param c     received byte
+ */
+void snap_rx_usb( uint8_t c )
+{
+    snap_rx_feed( &usb_rx, c );
+}
+#endif
+
+/**
+ * @brief Read a counter
+ *
+ * @param index     counter, from enum snap_stat
+ *
+ * @return counter value, 0 if index is out of range
+ */
+uint32_t snap_stat( uint8_t index )
+{
+    uint32_t value = 0;
+
+    if( kStatRxOverflows == index )
+        return USART0_RxOverflows();
+    if( kStatRxHighWater == index )
+        return USART0_RxHighWater();
+    if( index < kStatRxOverflows )
+    {
+        // The USART receiver may update its counters from its interrupt
+        ATOMIC_BLOCK( ATOMIC_RESTORESTATE )
+        {
+            value = snap_stats[index];
+        }
+    }
+    return value;
+}
+
+/**
+ * @brief Reset the counters kept by the S.N.A.P. code
+ *
+ * The baud rate timers, which count on them, are carried over first.
+ */
+void snap_stat_clear( void )
+{
+    uint8_t i;
+
+    ATOMIC_BLOCK( ATOMIC_RESTORESTATE )
+    {
+        snap_baud_stat_clear();
+        for( i = 0; i < kStatRxOverflows; ++i )
+        {
+            snap_stats[i] = 0;
+        }
+    }
+}
+
+/**
+ * @brief Initialize S.N.A.P processing task
+ */
+void snap_task_init( void )
+{
+    snap_pool_init();
+    snap_window_init();
+    snap_filter_init();
+    snap_vote_init();
+    rx_queue_head = 0;
+    rx_queue_tail = 0;
+    snap_stat_clear();
+    uart_rx.packet = NULL;
+    uart_rx.rescan = 0;
+    uart_rx.replay = false;
+    uart_rx.stats = kStatUart;
+    uart_rx.link = kSnapUart;
+    snap_rx_reset( &uart_rx );
+#if (SNAP_USB_TUNNEL == true)
+    usb_rx.packet = NULL;
+    usb_rx.rescan = 0;
+    usb_rx.replay = false;
+    usb_rx.stats = kStatUsb;
+    usb_rx.link = kSnapUsb;
+    snap_rx_reset( &usb_rx );
+    snap_usb_init();
+#endif
+    snap_baud_init();
+}
+
+/**
+ * @brief Process the received packets
+ *
+ * Copies of packets sent with EDM_3TX are first voted on, and only the voted
+ * packet goes further. Packets with a sequence number, see snap_window.h, go
+ * through the sliding window. Other packets requesting an ACK are answered
+ * before being processed: with an ACK if they passed error detection, with a
+ * NAK otherwise. An answer that does not fit in the transmit buffer is not
+ * sent; the sender will retry.
+ *
+ * Unless the receiver runs in the USART receive interrupt, every byte waiting
+ * in the USART receive buffer is fed to the receiver first, straight from the
+ * buffer. Baud rate changes are made last, see snap_baud_task().
+ */
+void snap_task( void )
+{
+    struct snap_packet *packet;
+#if (SNAP_RX_IN_ISR == false)
+    const unsigned char *span;
+    unsigned int n;
+    unsigned int i;
+
+    while( 0 != ( n = USART0_RxPeek( &span ) ) )
+    {
+        for( i = 0; i < n; ++i )
+        {
+            snap_rx_feed( &uart_rx, span[i] );
+        }
+        USART0_RxCommit( n );
+    }
+#endif
+
+    while( rx_queue_tail != rx_queue_head )
+    {
+        packet = rx_queue[rx_queue_tail & SNAP_POOL_MASK];
+        ++rx_queue_tail;
+
+        if( EDM_3TX == packet->hdb1.fields.EDM )
+        {
+            packet = snap_vote( packet );
+            if( NULL == packet )
+                continue;
+        }
+
+        if( Is_snap_windowed( packet ) )
+        {
+            snap_window_receive( packet );
+            continue;
+        }
+
+        if( ACK_REQ == packet->hdb2.fields.ACK )
+        {
+            snap_tx_ack( packet, packet->valid ? ACK_RESP : NAK_RESP, NULL, PFB_0 );
+        }
+
+        if( packet->valid )
+        {
+            process_packet( packet );
+        }
+        else
+        {
+            snap_packet_release( packet );
+        }
+    }
+
+    snap_baud_task();
+}
+
+/**
+ * @brief Act upon a received packet
+ *
+ * The packet belongs to this function from now on: it must either release it
+ * with snap_packet_release() or pass it on to a consumer that will.
+ *
+ * Command packets are handled by snap_cmd(). Other packets carry a message
+ * identified by their first data byte.
+ *
+ * @param packet    decoded packet
+ */
+void process_packet( struct snap_packet *packet )
+{
+    if( packet->hdb1.fields.CMD )
+    {
+        snap_cmd( packet );
+        return;
+    }
+
+    if( packet->length )
+    {
+        switch( packet->data[0] )
+        {
+            case HID_EVENT_MSG :
+                hid_event_receive( packet->data, packet->length );
+                break;
+
+            case HID_EVENT_BATCH_MSG :
+                hid_event_receive_batch( packet->data, packet->length );
+                break;
+
+            default :
+                break;
+        }
+    }
+    snap_packet_release( packet );
 }
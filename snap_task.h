@@ -0,0 +1,66 @@
+/**
+ * @file
+ *
+ * @brief This file contains the S.N.A.P. task definitions
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+#ifndef _SNAP_TASK_H_
+#define _SNAP_TASK_H_
+
+//_____ I N C L U D E S ________________________________________________________
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "snap_pool.h"
+
+//_____ M A C R O S ____________________________________________________________
+
+/// Counters of a receiver, from its first counter in enum snap_stat
+#define SNAP_STAT_BYTES         0       ///< Bytes received
+#define SNAP_STAT_FRAMES        1       ///< Valid packets queued for snap_task()
+#define SNAP_STAT_ERRORS        2       ///< Packets failing error detection
+#define SNAP_STAT_RESYNCS       3       ///< Packets searched again for a SYNC byte
+#define SNAP_STAT_LINK          4
+
+/// Increment a counter
+#define Snap_stat_inc(i)        ( ++snap_stats[i] )
+
+//_____ D E F I N I T I O N ____________________________________________________
+
+/**
+ * @brief Counters read with snap_stat()
+ */
+enum snap_stat
+{
+    kStatUart,                              ///< USART receiver, SNAP_STAT_xxx
+    kStatUsb = kStatUart + SNAP_STAT_LINK,  ///< USB receiver, SNAP_STAT_xxx
+    kStatAcks = kStatUsb + SNAP_STAT_LINK,  ///< ACKs sent
+    kStatNaks,                              ///< NAKs sent
+    kStatRxOverflows,                       ///< Bytes lost by the USART receive buffer
+    kStatRxHighWater,                       ///< Highest USART receive buffer usage
+    kStatCount
+};
+
+/// Counters kept by the S.N.A.P. code, up to kStatRxOverflows
+extern volatile uint32_t snap_stats[kStatRxOverflows];
+
+extern const uint16_t snap_ndb_length[16] PROGMEM;
+extern const uint8_t snap_edm_length[8] PROGMEM;
+extern const uint8_t snap_edm_supported;
+
+//_____ D E C L A R A T I O N __________________________________________________
+
+void snap_task_init( void );
+void snap_task( void );
+void process_packet( struct snap_packet *packet );
+void snap_rx_usb( uint8_t c );
+uint32_t snap_stat( uint8_t index );
+void snap_stat_clear( void );
+
+#endif /* _SNAP_TASK_H_ */
@@ -0,0 +1,316 @@
+/**
+ * @file
+ *
+ * @brief S.N.A.P. packet transmission
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+//_____  I N C L U D E S _______________________________________________________
+
+#include <stddef.h>
+#include <avr/pgmspace.h>
+#include "config.h"
+#include "snap.h"
+#include "snap_crc.h"
+#include "snap_fec.h"
+#include "snap_task.h"
+#include "snap_tx.h"
+#include "snap_usb.h"
+#include "lib_mcu/usart/usart.h"
+
+//_____ M A C R O S ____________________________________________________________
+
+/// Number of copies of an EDM_3TX packet
+#define SNAP_TX_3TX_COPIES      3
+
+//_____ V A R I A B L E S ______________________________________________________
+
+/// Link the packet being built is sent on, enum snap_link
+static uint8_t tx_link;
+/// Error detection method of the packet being built
+static uint8_t tx_edm;
+/// Checksum register of the packet being built
+static uint32_t tx_crc;
+/// Data bytes still expected for the packet being built
+static uint16_t tx_left;
+#if (SNAP_FEC_SUPPORT == true)
+/// FEC parity bytes of the packet being built, sent as its trailer
+static uint8_t tx_parity[SNAP_EDM_SIZE];
+/// Number of parity bytes in tx_parity
+static uint8_t tx_parity_n;
+#endif
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+/**
+ * @brief Reserve room for a packet in the transmit buffer of its link
+ *
+ * @param n     number of bytes
+ */
+static bool snap_tx_reserve( uint8_t n )
+{
+#if (SNAP_USB_TUNNEL == true)
+    if( kSnapUsb == tx_link )
+        return snap_usb_tx_reserve( n );
+#endif
+    return USART0_TxReserve( n );
+}
+
+/**
+ * @brief Store a byte in the transmit buffer of the link
+ *
+ * @param c     packet byte
+ */
+static void snap_tx_raw( uint8_t c )
+{
+#if (SNAP_USB_TUNNEL == true)
+    if( kSnapUsb == tx_link )
+    {
+        snap_usb_tx_put( c );
+        return;
+    }
+#endif
+    USART0_TxPut( c );
+}
+
+/**
+ * @brief Store copies of the packet after it
+ *
+ * @param copies    number of copies to add
+ */
+static void snap_tx_repeat( uint8_t copies )
+{
+#if (SNAP_USB_TUNNEL == true)
+    if( kSnapUsb == tx_link )
+    {
+        snap_usb_tx_repeat( copies );
+        return;
+    }
+#endif
+    USART0_TxRepeat( copies );
+}
+
+/**
+ * @brief Hand the packet over to its link
+ */
+static void snap_tx_commit( void )
+{
+#if (SNAP_USB_TUNNEL == true)
+    if( kSnapUsb == tx_link )
+    {
+        snap_usb_tx_commit();
+        return;
+    }
+#endif
+    USART0_TxCommit();
+}
+
+/**
+ * @brief Store a packet byte in the transmit buffer and add it to the checksum
+ *
+ * @param c     packet byte
+ */
+static void snap_tx_put( uint8_t c )
+{
+    snap_tx_raw( c );
+    tx_crc = snap_crc_update( tx_edm, tx_crc, c );
+#if (SNAP_FEC_SUPPORT == true)
+    if( EDM_FEC == tx_edm )
+    {
+        tx_parity[tx_parity_n++] = snap_fec_parity( c );
+    }
+#endif
+}
+
+/**
+ * @brief Store a big-endian address
+ *
+ * @param address   address
+ * @param n         number of address bytes (0-3)
+ */
+static void snap_tx_address( uint32_t address, uint8_t n )
+{
+    while( n-- )
+    {
+        snap_tx_put( ( uint8_t )( address >> ( 8 * n ) ) );
+    }
+}
+
+/**
+ * @brief Start a packet
+ *
+ * Reserves room for the whole packet in the transmit buffer and stores
+ * everything up to the data bytes, which must follow with snap_tx_byte() or
+ * snap_tx_data() before snap_tx_end() is called.
+ *
+ * @param link      link to send the packet on, enum snap_link
+ * @param hdb2      Header Definition Byte 2
+ * @param hdb1      Header Definition Byte 1
+ * @param dest      destination address, HDB2::DAB bytes are sent
+ * @param src       source address, HDB2::SAB bytes are sent
+ * @param flags     HDB2::PFB protocol specific flag bytes, may be NULL if PFB is 0
+ *
+ * With EDM_3TX, room is reserved for the three copies of the packet.
+ *
+ * @return false if the packet does not fit in the transmit buffer right now, or
+ * is too large to be sent with forward error correction or EDM_3TX
+ */
+bool snap_tx_begin( uint8_t link, uint8_t hdb2, uint8_t hdb1, uint32_t dest, uint32_t src, const uint8_t *flags )
+{
+    union HDB2 h2;
+    union HDB1 h1;
+    uint16_t trailer;
+    uint16_t size;
+    uint8_t i;
+
+    h2.raw = hdb2;
+    h1.raw = hdb1;
+    tx_link = link;
+    tx_edm = h1.fields.EDM;
+    tx_left = pgm_read_word( &snap_ndb_length[h1.fields.NDB] );
+
+    trailer = pgm_read_byte( &snap_edm_length[tx_edm] );
+#if (SNAP_FEC_SUPPORT == true)
+    if( EDM_FEC == tx_edm )
+    {
+        trailer = snap_fec_size( h2, tx_left );
+        if( trailer > SNAP_EDM_SIZE )
+            return false;
+        tx_parity_n = 0;
+    }
+#endif
+
+    size = 3 + h2.fields.DAB + h2.fields.SAB + h2.fields.PFB + tx_left + trailer;
+    if( EDM_3TX == tx_edm )
+    {
+        size *= SNAP_TX_3TX_COPIES;
+    }
+    if( ( size > 0xFF ) || !snap_tx_reserve( ( uint8_t )size ) )
+        return false;
+
+    snap_tx_raw( SYNC );
+    tx_crc = snap_crc_init( tx_edm );
+    snap_tx_put( hdb2 );
+    snap_tx_put( hdb1 );
+    snap_tx_address( dest, h2.fields.DAB );
+    snap_tx_address( src, h2.fields.SAB );
+    for( i = 0; i < h2.fields.PFB; ++i )
+    {
+        snap_tx_put( flags[i] );
+    }
+    return true;
+}
+
+/**
+ * @brief Store one data byte of the packet
+ *
+ * Bytes beyond the HDB1::NDB length of the packet are ignored.
+ *
+ * @param c     data byte
+ */
+void snap_tx_byte( uint8_t c )
+{
+    if( tx_left )
+    {
+        --tx_left;
+        snap_tx_put( c );
+    }
+}
+
+/**
+ * @brief Store data bytes of the packet
+ *
+ * @param data  data bytes
+ * @param n     number of data bytes
+ */
+void snap_tx_data( const uint8_t *data, uint16_t n )
+{
+    while( n-- )
+    {
+        snap_tx_byte( *data++ );
+    }
+}
+
+/**
+ * @brief Finish the packet and start sending it
+ *
+ * Missing data bytes are padded with zeros, then the error detection bytes
+ * are appended: the checksum, or the FEC parity bytes. An EDM_3TX packet,
+ * which has none, is followed by its two other copies instead.
+ */
+void snap_tx_end( void )
+{
+    uint32_t crc;
+    uint8_t n;
+
+    while( tx_left )
+    {
+        snap_tx_byte( 0 );
+    }
+
+#if (SNAP_FEC_SUPPORT == true)
+    if( EDM_FEC == tx_edm )
+    {
+        for( n = 0; n < tx_parity_n; ++n )
+        {
+            snap_tx_raw( tx_parity[n] );
+        }
+        snap_tx_commit();
+        return;
+    }
+#endif
+
+    crc = snap_crc_final( tx_edm, tx_crc );
+    n = pgm_read_byte( &snap_edm_length[tx_edm] );
+    while( n-- )
+    {
+        snap_tx_raw( ( uint8_t )( crc >> ( 8 * n ) ) );
+    }
+    if( EDM_3TX == tx_edm )
+    {
+        snap_tx_repeat( SNAP_TX_3TX_COPIES - 1 );
+    }
+    snap_tx_commit();
+}
+
+/**
+ * @brief Answer a packet with an ACK or NAK packet
+ *
+ * The answer goes back to the source of the packet on the link it came from,
+ * from the address the packet was sent to, using the same error detection
+ * method: an answer to
+ * EDM_3TX copies is sent three times as well, so that the voter of the peer
+ * accepts it.
+ *
+ * @param packet    received packet
+ * @param ack       ACK_RESP or NAK_RESP
+ * @param flags     protocol specific flag bytes of the answer, may be NULL if pfb is 0
+ * @param pfb       number of flag bytes (PFB_0 to PFB_3)
+ *
+ * @return false if the answer does not fit in the transmit buffer right now
+ */
+bool snap_tx_ack( const struct snap_packet *packet, uint8_t ack, const uint8_t *flags, uint8_t pfb )
+{
+    union HDB2 hdb2;
+    union HDB1 hdb1;
+
+    hdb2.raw = 0;
+    hdb2.fields.DAB = packet->hdb2.fields.SAB;
+    hdb2.fields.SAB = packet->hdb2.fields.DAB;
+    hdb2.fields.PFB = pfb;
+    hdb2.fields.ACK = ack;
+    hdb1.raw = 0;
+    hdb1.fields.EDM = packet->hdb1.fields.EDM;
+    hdb1.fields.NDB = NDB_0;
+
+    if( !snap_tx_begin( packet->link, hdb2.raw, hdb1.raw, packet->src, packet->dest, flags ) )
+        return false;
+    snap_tx_end();
+    Snap_stat_inc( ( NAK_RESP == ack ) ? kStatNaks : kStatAcks );
+    return true;
+}
@@ -0,0 +1,35 @@
+/**
+ * @file
+ *
+ * @brief S.N.A.P. packet transmission
+ *
+ * Packets are serialized straight into the transmit buffer of their link: the
+ * USART transmit buffer, or the buffer of answers read through USB. Room for
+ * the complete packet is reserved by snap_tx_begin(), so building a packet
+ * never waits; the packet is only handed to the link by snap_tx_end().
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+#ifndef _SNAP_TX_H_
+#define _SNAP_TX_H_
+
+//_____ I N C L U D E S ________________________________________________________
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "snap_pool.h"
+
+//_____ D E C L A R A T I O N __________________________________________________
+
+bool snap_tx_begin( uint8_t link, uint8_t hdb2, uint8_t hdb1, uint32_t dest, uint32_t src, const uint8_t *flags );
+void snap_tx_byte( uint8_t c );
+void snap_tx_data( const uint8_t *data, uint16_t n );
+void snap_tx_end( void );
+bool snap_tx_ack( const struct snap_packet *packet, uint8_t ack, const uint8_t *flags, uint8_t pfb );
+
+#endif /* _SNAP_TX_H_ */
@@ -0,0 +1,128 @@
+/**
+ * @file
+ *
+ * @brief S.N.A.P. answers to packets tunnelled through USB
+ *
+ * The buffer works as the USART transmit buffer does: room for a whole
+ * packet is reserved first, and the packet can only be read once committed.
+ * It is written by snap_task() and read by the control request handler, both
+ * outside interrupts.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+//_____  I N C L U D E S _______________________________________________________
+
+#include "config.h"
+#include "snap_usb.h"
+
+//_____ M A C R O S ____________________________________________________________
+
+#define SNAP_USB_TX_MASK        ( SNAP_USB_TX_BUFFER_SIZE - 1 )
+#if ( SNAP_USB_TX_BUFFER_SIZE & SNAP_USB_TX_MASK ) || ( SNAP_USB_TX_BUFFER_SIZE > 256 )
+#error SNAP_USB_TX_BUFFER_SIZE is not a power of 2 up to 256
+#endif
+
+//_____ V A R I A B L E S ______________________________________________________
+
+static uint8_t tx_buf[SNAP_USB_TX_BUFFER_SIZE];
+/// Last committed byte
+static uint8_t tx_head;
+/// Last byte read
+static uint8_t tx_tail;
+/// Last byte stored since snap_usb_tx_reserve()
+static uint8_t tx_pending;
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+/**
+ * @brief Drop every answer waiting
+ */
+void snap_usb_init( void )
+{
+    tx_head = 0;
+    tx_tail = 0;
+    tx_pending = 0;
+}
+
+/**
+ * @brief Reserve room for a packet, without waiting
+ *
+ * @param n     number of bytes
+ *
+ * @return false if the buffer does not have room for n bytes
+ */
+bool snap_usb_tx_reserve( uint8_t n )
+{
+    // One slot always stays empty to tell a full buffer from an empty one
+    if( n > ( SNAP_USB_TX_MASK - ( ( tx_head - tx_tail ) & SNAP_USB_TX_MASK ) ) )
+        return false;
+
+    tx_pending = tx_head;
+    return true;
+}
+
+/**
+ * @brief Store a byte of the reserved packet
+ *
+ * @param c     packet byte
+ */
+void snap_usb_tx_put( uint8_t c )
+{
+    tx_pending = ( tx_pending + 1 ) & SNAP_USB_TX_MASK;
+    tx_buf[tx_pending] = c;
+}
+
+/**
+ * @brief Store copies of the bytes stored since snap_usb_tx_reserve() after them
+ *
+ * @param copies    number of copies to add, room for them must have been reserved
+ */
+void snap_usb_tx_repeat( uint8_t copies )
+{
+    uint8_t n = ( tx_pending - tx_head ) & SNAP_USB_TX_MASK;
+    uint8_t src;
+    uint8_t i;
+
+    while( copies-- )
+    {
+        src = tx_head;
+        for( i = 0; i < n; ++i )
+        {
+            src = ( src + 1 ) & SNAP_USB_TX_MASK;
+            snap_usb_tx_put( tx_buf[src] );
+        }
+    }
+}
+
+/**
+ * @brief Make the bytes stored since snap_usb_tx_reserve() available to the host
+ */
+void snap_usb_tx_commit( void )
+{
+    tx_head = tx_pending;
+}
+
+/**
+ * @brief Take committed bytes for an input report
+ *
+ * @param p     destination
+ * @param n     largest number of bytes to take
+ *
+ * @return number of bytes taken
+ */
+uint8_t snap_usb_tx_read( uint8_t *p, uint8_t n )
+{
+    uint8_t i;
+
+    for( i = 0; ( i < n ) && ( tx_tail != tx_head ); ++i )
+    {
+        tx_tail = ( tx_tail + 1 ) & SNAP_USB_TX_MASK;
+        p[i] = tx_buf[tx_tail];
+    }
+    return i;
+}
@@ -0,0 +1,36 @@
+/**
+ * @file
+ *
+ * @brief S.N.A.P. answers to packets tunnelled through USB
+ *
+ * Packets received through REPORT_ID_SNAP output reports are answered through
+ * USB as well: snap_tx.c serializes the answers into a buffer of their own,
+ * which the host reads with HID GET_REPORT requests for a REPORT_ID_SNAP input
+ * report. Each report is laid out as the output reports are: the report ID,
+ * the number of S.N.A.P. bytes that follow, then padding.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+#ifndef _SNAP_USB_H_
+#define _SNAP_USB_H_
+
+//_____ I N C L U D E S ________________________________________________________
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//_____ D E C L A R A T I O N __________________________________________________
+
+void snap_usb_init( void );
+bool snap_usb_tx_reserve( uint8_t n );
+void snap_usb_tx_put( uint8_t c );
+void snap_usb_tx_repeat( uint8_t copies );
+void snap_usb_tx_commit( void );
+uint8_t snap_usb_tx_read( uint8_t *p, uint8_t n );
+
+#endif /* _SNAP_USB_H_ */
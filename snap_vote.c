@@ -0,0 +1,191 @@
+/**
+ * @file
+ *
+ * @brief S.N.A.P. triple transmission (EDM_3TX) voting
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+//_____  I N C L U D E S _______________________________________________________
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "snap.h"
+#include "snap_vote.h"
+
+//_____ M A C R O S ____________________________________________________________
+
+#if ( SNAP_LINKS * ( SNAP_WINDOW_SIZE + 2 ) >= SNAP_POOL_SIZE )
+#error SNAP_POOL_SIZE must leave room for two held EDM_3TX copies and the sliding window of each link
+#endif
+
+//_____ T Y P E S ______________________________________________________________
+
+/**
+ * @brief Voting state of one link
+ */
+struct snap_voter
+{
+    /// Last copies received that were not part of an accepted packet, oldest first
+    struct snap_packet *copies[2];
+    /// Number of copies held
+    uint8_t held;
+    /// Remaining copy of the last accepted packet to drop: its size, 0 if none
+    uint16_t skip_size;
+    /// Header definition bytes of the copy to drop
+    uint8_t skip_hdb2;
+    uint8_t skip_hdb1;
+};
+
+//_____ V A R I A B L E S ______________________________________________________
+
+static struct snap_voter voters[SNAP_LINKS];
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+/**
+ * @brief Compare two copies of a packet
+ */
+static bool snap_vote_equal( const struct snap_packet *a, const struct snap_packet *b )
+{
+    return ( a->size == b->size ) && ( 0 == memcmp( a->raw, b->raw, a->size ) );
+}
+
+/**
+ * @brief Merge three copies of a packet by majority vote, in place in the third one
+ *
+ * @return false if the copies differ in size, if a byte differs in all three
+ * copies, or if the header definition bytes of the third copy were repaired,
+ * since its size was received according to the corrupted header
+ */
+static bool snap_vote_merge( const struct snap_packet *a, const struct snap_packet *b, struct snap_packet *c )
+{
+    uint16_t i;
+    uint8_t x;
+    uint8_t y;
+
+    if( ( a->size != c->size ) || ( b->size != c->size ) )
+        return false;
+
+    for( i = 0; i < c->size; ++i )
+    {
+        x = a->raw[i];
+        y = b->raw[i];
+        if( x == y )
+        {
+            c->raw[i] = x;
+        }
+        else if( ( x != c->raw[i] ) && ( y != c->raw[i] ) )
+        {
+            return false;
+        }
+    }
+
+    if( ( c->raw[0] != c->hdb2.raw ) || ( c->raw[1] != c->hdb1.raw ) )
+        return false;
+
+    snap_packet_decode( c );
+    return true;
+}
+
+/**
+ * @brief Return the held copies of a link to the pool
+ */
+static void snap_vote_flush( struct snap_voter *v )
+{
+    while( v->held )
+    {
+        snap_packet_release( v->copies[--v->held] );
+    }
+}
+
+/**
+ * @brief Accept a packet, dropping the copies received before it
+ *
+ * @param v         voting state of the link of the packet
+ * @param packet    accepted packet
+ * @param skip      true if a copy of the packet is still to come
+ */
+static struct snap_packet *snap_vote_accept( struct snap_voter *v, struct snap_packet *packet, bool skip )
+{
+    snap_vote_flush( v );
+    v->skip_size = skip ? packet->size : 0;
+    v->skip_hdb2 = packet->hdb2.raw;
+    v->skip_hdb1 = packet->hdb1.raw;
+    return packet;
+}
+
+/**
+ * @brief Forget any partly received packet
+ */
+void snap_vote_init( void )
+{
+    uint8_t i;
+
+    for( i = 0; i < SNAP_LINKS; ++i )
+    {
+        snap_vote_flush( &voters[i] );
+        voters[i].skip_size = 0;
+    }
+}
+
+/**
+ * @brief Vote on a received EDM_3TX copy
+ *
+ * A packet is accepted as soon as a copy matches one of the two copies held
+ * before it. The third copy of a packet accepted on its second one is dropped
+ * if its size and header definition bytes match; should it be the first copy
+ * of a new, similar packet instead, the other two copies still agree.
+ *
+ * When three copies of the same size differ, each byte is taken from the two
+ * copies that agree on it. Copies that cannot be reconciled are kept in
+ * sequence, oldest dropped first, so the voter falls back into step with the
+ * sender after a lost copy. Each link is voted on apart.
+ *
+ * Takes ownership of the packet.
+ *
+ * @param packet    received packet, HDB1::EDM must be EDM_3TX
+ *
+ * @return the voted packet once it is known, NULL otherwise
+ */
+struct snap_packet *snap_vote( struct snap_packet *packet )
+{
+    struct snap_voter *v = &voters[packet->link];
+    uint8_t i;
+
+    if( v->skip_size )
+    {
+        if( ( packet->size == v->skip_size ) &&
+            ( packet->hdb2.raw == v->skip_hdb2 ) &&
+            ( packet->hdb1.raw == v->skip_hdb1 ) )
+        {
+            v->skip_size = 0;
+            snap_packet_release( packet );
+            return NULL;
+        }
+        v->skip_size = 0;
+    }
+
+    for( i = 0; i < v->held; ++i )
+    {
+        if( snap_vote_equal( v->copies[i], packet ) )
+            return snap_vote_accept( v, packet, 1 == v->held );
+    }
+
+    if( ( 2 == v->held ) && snap_vote_merge( v->copies[0], v->copies[1], packet ) )
+        return snap_vote_accept( v, packet, false );
+
+    if( 2 == v->held )
+    {
+        snap_packet_release( v->copies[0] );
+        v->copies[0] = v->copies[1];
+        --v->held;
+    }
+    v->copies[v->held++] = packet;
+    return NULL;
+}
@@ -0,0 +1,30 @@
+/**
+ * @file
+ *
+ * @brief S.N.A.P. triple transmission (EDM_3TX) voting
+ *
+ * Packets sent with EDM_3TX arrive three times. The first two copies are
+ * held; a packet is accepted as soon as two copies are identical, otherwise
+ * the three copies are merged byte by byte by majority vote, which repairs
+ * any byte corrupted in a single copy.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+#ifndef _SNAP_VOTE_H_
+#define _SNAP_VOTE_H_
+
+//_____ I N C L U D E S ________________________________________________________
+
+#include "snap_pool.h"
+
+//_____ D E C L A R A T I O N __________________________________________________
+
+void snap_vote_init( void );
+struct snap_packet *snap_vote( struct snap_packet *packet );
+
+#endif /* _SNAP_VOTE_H_ */
@@ -0,0 +1,167 @@
+/**
+ * @file
+ *
+ * @brief S.N.A.P. sliding window delivery
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+//_____  I N C L U D E S _______________________________________________________
+
+#include <stddef.h>
+#include "snap.h"
+#include "snap_task.h"
+#include "snap_tx.h"
+#include "snap_window.h"
+
+//_____ M A C R O S ____________________________________________________________
+
+#if ( SNAP_LINKS * SNAP_WINDOW_SIZE >= SNAP_POOL_SIZE )
+#error SNAP_WINDOW_SIZE must leave at least one buffer to receive into on each link
+#endif
+
+/// Held packet slots, a power of 2 not below the window size
+#define SNAP_HELD_SLOTS         8
+#define SNAP_HELD_MASK          ( SNAP_HELD_SLOTS - 1 )
+
+#if ( SNAP_WINDOW_SIZE > SNAP_HELD_SLOTS )
+#error SNAP_WINDOW_SIZE must not exceed 8
+#endif
+
+//_____ T Y P E S ______________________________________________________________
+
+/**
+ * @brief Sliding window of one link
+ */
+struct snap_window
+{
+    /// Next sequence number to deliver
+    uint8_t expected;
+    /// Packets received ahead of the expected one, by sequence number
+    struct snap_packet *held[SNAP_HELD_SLOTS];
+};
+
+//_____ V A R I A B L E S ______________________________________________________
+
+static struct snap_window windows[SNAP_LINKS];
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+/**
+ * @brief Answer a packet with an ACK or NAK carrying a sequence number
+ *
+ * @param packet    received packet
+ * @param ack       ACK_RESP or NAK_RESP
+ * @param seq       acknowledged or missing sequence number
+ */
+static void snap_window_answer( const struct snap_packet *packet, uint8_t ack, uint8_t seq )
+{
+    seq |= SNAP_SEQ_WINDOW;
+    snap_tx_ack( packet, ack, &seq, PFB_1 );
+}
+
+/**
+ * @brief Return the held packets of a link to the pool
+ */
+static void snap_window_flush( struct snap_window *w )
+{
+    uint8_t i;
+
+    for( i = 0; i < SNAP_HELD_SLOTS; ++i )
+    {
+        if( NULL != w->held[i] )
+        {
+            snap_packet_release( w->held[i] );
+            w->held[i] = NULL;
+        }
+    }
+}
+
+/**
+ * @brief Restart the window of every link at sequence number 0
+ */
+void snap_window_init( void )
+{
+    uint8_t i;
+
+    for( i = 0; i < SNAP_LINKS; ++i )
+    {
+        windows[i].expected = 0;
+        snap_window_flush( &windows[i] );
+    }
+}
+
+/**
+ * @brief Deliver a windowed packet in sequence
+ *
+ * Each link has its own window. Takes ownership of the packet, like
+ * process_packet().
+ *
+ * @param packet    received packet, Is_snap_windowed() must be true
+ */
+void snap_window_receive( struct snap_packet *packet )
+{
+    struct snap_window *w = &windows[packet->link];
+    uint8_t seq;
+    uint8_t ahead;
+    uint8_t first;
+
+    if( !packet->valid )
+    {
+        // The sequence number cannot be trusted, report the first gap
+        snap_window_answer( packet, NAK_RESP, w->expected );
+        snap_packet_release( packet );
+        return;
+    }
+
+    seq = packet->flags[0] & SNAP_SEQ_MASK;
+    if( packet->flags[0] & SNAP_SEQ_RESTART )
+    {
+        snap_window_flush( w );
+        w->expected = seq;
+    }
+
+    ahead = ( seq - w->expected ) & SNAP_SEQ_MASK;
+    if( 0 == ahead )
+    {
+        // Find how far the held packets extend the in-order run
+        first = w->expected;
+        do
+        {
+            w->expected = ( w->expected + 1 ) & SNAP_SEQ_MASK;
+        } while( NULL != w->held[w->expected & SNAP_HELD_MASK] );
+
+        snap_window_answer( packet, ACK_RESP, ( w->expected - 1 ) & SNAP_SEQ_MASK );
+
+        process_packet( packet );
+        for( first = ( first + 1 ) & SNAP_SEQ_MASK; first != w->expected; first = ( first + 1 ) & SNAP_SEQ_MASK )
+        {
+            packet = w->held[first & SNAP_HELD_MASK];
+            w->held[first & SNAP_HELD_MASK] = NULL;
+            process_packet( packet );
+        }
+    }
+    else if( ahead < SNAP_WINDOW_SIZE )
+    {
+        // Hold on to it and ask for the missing one
+        snap_window_answer( packet, NAK_RESP, w->expected );
+        if( NULL == w->held[seq & SNAP_HELD_MASK] )
+        {
+            w->held[seq & SNAP_HELD_MASK] = packet;
+        }
+        else
+        {
+            snap_packet_release( packet );
+        }
+    }
+    else
+    {
+        // Already delivered (our ACK was lost) or beyond the window
+        snap_window_answer( packet, ACK_RESP, ( w->expected - 1 ) & SNAP_SEQ_MASK );
+        snap_packet_release( packet );
+    }
+}
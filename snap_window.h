@@ -0,0 +1,51 @@
+/**
+ * @file
+ *
+ * @brief S.N.A.P. sliding window delivery
+ *
+ * A sender opts in packet by packet: a packet requesting an ACK whose first
+ * protocol specific flag byte has SNAP_SEQ_WINDOW set carries a sequence
+ * number in that byte. Other packets, flag bytes or not, are answered on
+ * their own as before. Up to SNAP_WINDOW_SIZE sequenced packets may be in
+ * flight: packets received out of order are held until the missing ones
+ * arrive, the highest in-order sequence number is acknowledged
+ * cumulatively, and each gap is reported with a NAK carrying the missing
+ * sequence number. The flag byte of these answers has SNAP_SEQ_WINDOW set
+ * as well.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+#ifndef _SNAP_WINDOW_H_
+#define _SNAP_WINDOW_H_
+
+//_____ I N C L U D E S ________________________________________________________
+
+#include "snap_pool.h"
+
+//_____ M A C R O S ____________________________________________________________
+
+/// Sequence number bits of the first flag byte
+#define SNAP_SEQ_MASK           ( ( uint8_t ) 0x3F )
+
+/// Restart bit of the first flag byte: the window restarts at this packet
+#define SNAP_SEQ_RESTART        ( ( uint8_t ) 0x40 )
+
+/// Window bit of the first flag byte: the packet is sequenced
+#define SNAP_SEQ_WINDOW         ( ( uint8_t ) 0x80 )
+
+/// Packet belongs to the sliding window
+#define Is_snap_windowed(p)     ( ( ACK_REQ == ( p )->hdb2.fields.ACK ) && \
+                                  ( PFB_0 != ( p )->hdb2.fields.PFB ) && \
+                                  ( 0 != ( ( p )->flags[0] & SNAP_SEQ_WINDOW ) ) )
+
+//_____ D E C L A R A T I O N __________________________________________________
+
+void snap_window_init( void );
+void snap_window_receive( struct snap_packet *packet );
+
+#endif /* _SNAP_WINDOW_H_ */
@@ -0,0 +1,25 @@
+/**
+ * @file
+ *
+ * @brief Host stand-in for the AVR interrupt definitions
+ *
+ * Interrupt handlers become ordinary functions, which a host program may call
+ * to simulate the interrupt.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+#ifndef _HOST_INTERRUPT_H_
+#define _HOST_INTERRUPT_H_
+
+#define ISR(vector)             void vector( void ); \
+                                void vector( void )
+
+#define sei()
+#define cli()
+
+#endif /* _HOST_INTERRUPT_H_ */
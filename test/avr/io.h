@@ -0,0 +1,77 @@
+/**
+ * @file
+ *
+ * @brief Host stand-in for the AT90USB1287 registers
+ *
+ * Only the registers and bits the modules built on the host touch are
+ * declared; the registers are ordinary variables, defined in host_io.c.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+#ifndef _HOST_IO_H_
+#define _HOST_IO_H_
+
+#include <stdint.h>
+
+// Timer 1
+extern volatile uint8_t TCCR1A;
+extern volatile uint8_t TCCR1B;
+extern volatile uint8_t TIFR1;
+extern volatile uint8_t TIMSK1;
+extern volatile uint16_t TCNT1;
+extern volatile uint16_t OCR1A;
+extern volatile uint16_t OCR1B;
+
+#define CS10                    0
+#define CS11                    1
+#define CS12                    2
+#define TOV1                    0
+#define OCF1A                   1
+#define OCF1B                   2
+#define OCIE1A                  1
+#define OCIE1B                  2
+
+// Board LEDs and joystick
+extern volatile uint8_t DDRB;
+extern volatile uint8_t DDRD;
+extern volatile uint8_t DDRE;
+extern volatile uint8_t PORTB;
+extern volatile uint8_t PORTD;
+extern volatile uint8_t PORTE;
+extern volatile uint8_t PINB;
+extern volatile uint8_t PIND;
+extern volatile uint8_t PINE;
+
+#define PINB5                   5
+#define PINB6                   6
+#define PINB7                   7
+#define PIND4                   4
+#define PIND5                   5
+#define PIND6                   6
+#define PIND7                   7
+#define PINE4                   4
+#define PINE5                   5
+
+// USB endpoints
+extern volatile uint8_t UENUM;
+extern volatile uint8_t UEINTX;
+extern volatile uint8_t UEDATX;
+extern volatile uint8_t UEBCLX;
+extern volatile uint8_t UEIENX;
+
+#define TXINI                   0
+#define RXOUTI                  2
+#define RXSTPI                  3
+#define NAKINI                  6
+#define RWAL                    5
+#define FIFOCON                 7
+
+#define RXOUTE                  2
+#define RXSTPE                  3
+
+#endif /* _HOST_IO_H_ */
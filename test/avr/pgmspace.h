@@ -0,0 +1,25 @@
+/**
+ * @file
+ *
+ * @brief Host stand-in for the avr-libc program memory access
+ *
+ * Flash tables are ordinary constant data on the host.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+#ifndef _HOST_PGMSPACE_H_
+#define _HOST_PGMSPACE_H_
+
+#include <stdint.h>
+
+#define PROGMEM
+#define pgm_read_byte(a)        ( *( const uint8_t * )( a ) )
+#define pgm_read_word(a)        ( *( const uint16_t * )( a ) )
+#define pgm_read_dword(a)       ( *( const uint32_t * )( a ) )
+
+#endif /* _HOST_PGMSPACE_H_ */
@@ -0,0 +1,44 @@
+/**
+ * @file
+ *
+ * @brief Time stamps for the host benchmarks
+ *
+ * Counts CPU cycles on x86 hosts, nanoseconds elsewhere. Host figures only
+ * compare implementations with each other; they say nothing of AVR timings.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdint.h>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>
+
+#define BENCH_UNIT              "cycles"
+
+static inline uint64_t bench_now( void )
+{
+    return __rdtsc();
+}
+#else
+#include <time.h>
+
+#define BENCH_UNIT              "ns"
+
+static inline uint64_t bench_now( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ( uint64_t )ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+#endif
+
+#endif /* _BENCH_H_ */
@@ -0,0 +1,156 @@
+/**
+ * @file
+ *
+ * @brief Host check and benchmark of the S.N.A.P. checksum tables
+ *
+ * Every error detection method of snap_crc.h is checked against a bitwise
+ * reference, on the standard check string and on random data, then both are
+ * timed per byte.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+//_____  I N C L U D E S _______________________________________________________
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "snap_crc.h"
+
+//_____ M A C R O S ____________________________________________________________
+
+#define BENCH_SIZE              4096
+#define BENCH_ROUNDS            256
+
+//_____ V A R I A B L E S ______________________________________________________
+
+static const struct
+{
+    uint8_t edm;
+    const char *name;
+    /// Checksum of "123456789"
+    uint32_t check;
+} methods[] =
+{
+    { EDM_CHKSUM8, "CHKSUM8", 0xDD },
+    { EDM_CRC8, "CRC-8/MAXIM", 0xA1 },
+    { EDM_CRC16, "CRC-16/XMODEM", 0x31C3 },
+    { EDM_CRC32, "CRC-32", 0xCBF43926UL },
+};
+
+static uint8_t buffer[BENCH_SIZE];
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+/**
+ * @brief Bitwise reference of snap_crc_update()
+ */
+static uint32_t crc_bitwise( uint8_t edm, uint32_t crc, uint8_t c )
+{
+    uint8_t i;
+
+    switch( edm )
+    {
+        case EDM_CHKSUM8 :
+            return ( uint8_t )( crc + c );
+
+        case EDM_CRC8 :
+            crc ^= c;
+            for( i = 0; i < 8; ++i )
+                crc = ( crc & 1 ) ? ( crc >> 1 ) ^ 0x8C : crc >> 1;
+            return crc;
+
+        case EDM_CRC16 :
+            crc ^= ( uint32_t )c << 8;
+            for( i = 0; i < 8; ++i )
+                crc = ( crc & 0x8000 ) ? ( crc << 1 ) ^ 0x1021 : crc << 1;
+            return ( uint16_t )crc;
+
+        case EDM_CRC32 :
+            crc ^= c;
+            for( i = 0; i < 8; ++i )
+                crc = ( crc & 1 ) ? ( crc >> 1 ) ^ 0xEDB88320UL : crc >> 1;
+            return crc;
+
+        default :
+            return crc;
+    }
+}
+
+static uint32_t crc_table_run( uint8_t edm, const uint8_t *p, size_t n )
+{
+    uint32_t crc = snap_crc_init( edm );
+
+    while( n-- )
+        crc = snap_crc_update( edm, crc, *p++ );
+    return snap_crc_final( edm, crc );
+}
+
+static uint32_t crc_bitwise_run( uint8_t edm, const uint8_t *p, size_t n )
+{
+    uint32_t crc = snap_crc_init( edm );
+
+    while( n-- )
+        crc = crc_bitwise( edm, crc, *p++ );
+    return snap_crc_final( edm, crc );
+}
+
+/**
+ * @brief Time one implementation
+ *
+ * @return time per byte, in BENCH_UNIT
+ */
+static double crc_time( uint32_t ( *run )( uint8_t, const uint8_t *, size_t ), uint8_t edm )
+{
+    volatile uint32_t sink = 0;
+    uint64_t start;
+    uint64_t best = UINT64_MAX;
+    uint64_t t;
+    int i;
+
+    for( i = 0; i < BENCH_ROUNDS; ++i )
+    {
+        start = bench_now();
+        sink ^= run( edm, buffer, sizeof( buffer ) );
+        t = bench_now() - start;
+        if( t < best )
+            best = t;
+    }
+    ( void )sink;
+    return ( double )best / sizeof( buffer );
+}
+
+int main( void )
+{
+    static const uint8_t check[] = "123456789";
+    unsigned m;
+    size_t i;
+    int failed = 0;
+    uint32_t table;
+    uint32_t bitwise;
+    int ok;
+
+    srand( 1 );
+    for( i = 0; i < sizeof( buffer ); ++i )
+        buffer[i] = ( uint8_t )rand();
+
+    printf( "%-14s %10s %10s %8s %8s\n", "method", "check", "random", "table", "bitwise" );
+    for( m = 0; m < sizeof( methods ) / sizeof( methods[0] ); ++m )
+    {
+        table = crc_table_run( methods[m].edm, check, 9 );
+        bitwise = crc_bitwise_run( methods[m].edm, check, 9 );
+        ok = ( table == methods[m].check ) && ( bitwise == methods[m].check );
+        table = crc_table_run( methods[m].edm, buffer, sizeof( buffer ) );
+        bitwise = crc_bitwise_run( methods[m].edm, buffer, sizeof( buffer ) );
+        failed |= !ok || ( table != bitwise );
+        printf( "%-14s %10s %10s %8.2f %8.2f %s/byte\n", methods[m].name,
+                ok ? "ok" : "FAIL", ( table == bitwise ) ? "ok" : "FAIL",
+                crc_time( crc_table_run, methods[m].edm ),
+                crc_time( crc_bitwise_run, methods[m].edm ), BENCH_UNIT );
+    }
+    return failed;
+}
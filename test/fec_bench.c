@@ -0,0 +1,166 @@
+/**
+ * @file
+ *
+ * @brief Host check and benchmark of the EDM_FEC encoder and decoder
+ *
+ * Every codeword is checked with each single flipped bit, which must be
+ * corrected, and each pair of flipped bits within a nibble, which must be
+ * detected. Encoding and decoding are then timed per byte, on clean packets
+ * and on packets with one flipped bit per byte.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+//_____  I N C L U D E S _______________________________________________________
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "snap_fec.h"
+
+//_____ M A C R O S ____________________________________________________________
+
+/// Protected bytes of the largest packet a pool buffer holds: header and 64 data bytes
+#define BENCH_SIZE              ( 11 + 64 )
+#define BENCH_ROUNDS            4096
+
+//_____ V A R I A B L E S ______________________________________________________
+
+static uint8_t clean[BENCH_SIZE];
+static uint8_t clean_parity[BENCH_SIZE];
+static uint8_t noisy[BENCH_SIZE];
+static uint8_t noisy_parity[BENCH_SIZE];
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+/**
+ * @brief Decode one byte with flipped bits
+ *
+ * @param c         byte sent
+ * @param flip      bits flipped: byte in bits 0-7, parity in bits 8-15
+ * @param fixed     set to the decoded byte
+ *
+ * @return snap_fec_decode() result
+ */
+static bool fec_try( uint8_t c, uint16_t flip, uint8_t *fixed )
+{
+    uint8_t parity = snap_fec_parity( c ) ^ ( uint8_t )( flip >> 8 );
+
+    *fixed = c ^ ( uint8_t )flip;
+    return snap_fec_decode( fixed, 1, &parity );
+}
+
+/**
+ * @brief Check every byte against every single and double error in a nibble
+ *
+ * @return number of failures
+ */
+static unsigned fec_check( void )
+{
+    static const uint16_t nibble[2] = { 0x0F0F, 0xF0F0 };
+    unsigned failures = 0;
+    unsigned c;
+    unsigned a;
+    unsigned b;
+    unsigned h;
+    uint8_t fixed;
+
+    for( c = 0; c < 256; ++c )
+    {
+        if( !fec_try( c, 0, &fixed ) || ( fixed != c ) )
+            ++failures;
+        for( a = 0; a < 16; ++a )
+        {
+            if( !fec_try( c, 1 << a, &fixed ) || ( fixed != c ) )
+                ++failures;
+        }
+        for( h = 0; h < 2; ++h )
+        {
+            for( a = 0; a < 16; ++a )
+            {
+                for( b = a + 1; b < 16; ++b )
+                {
+                    if( ( nibble[h] & ( 1 << a ) ) && ( nibble[h] & ( 1 << b ) ) &&
+                        fec_try( c, ( 1 << a ) | ( 1 << b ), &fixed ) )
+                        ++failures;
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+static void fec_encode( const uint8_t *p, uint8_t *parity, uint16_t n )
+{
+    while( n-- )
+        *parity++ = snap_fec_parity( *p++ );
+}
+
+/**
+ * @brief Time a run over a packet
+ *
+ * @return time per byte, in BENCH_UNIT
+ */
+static double fec_time( int decode, const uint8_t *p, const uint8_t *parity )
+{
+    uint8_t work[BENCH_SIZE];
+    uint8_t out[BENCH_SIZE];
+    uint64_t start;
+    uint64_t best = UINT64_MAX;
+    uint64_t t;
+    int i;
+
+    for( i = 0; i < BENCH_ROUNDS; ++i )
+    {
+        memcpy( work, p, BENCH_SIZE );
+        start = bench_now();
+        if( decode )
+        {
+            if( !snap_fec_decode( work, BENCH_SIZE, parity ) )
+                abort();
+        }
+        else
+        {
+            fec_encode( work, out, BENCH_SIZE );
+        }
+        t = bench_now() - start;
+        __asm__ volatile( "" : : "r"( work ), "r"( out ) : "memory" );
+        if( t < best )
+            best = t;
+    }
+    return ( double )best / BENCH_SIZE;
+}
+
+int main( void )
+{
+    unsigned failures;
+    unsigned i;
+
+    failures = fec_check();
+    printf( "single errors corrected, double errors detected: %s\n", failures ? "FAIL" : "ok" );
+
+    srand( 1 );
+    for( i = 0; i < BENCH_SIZE; ++i )
+        clean[i] = ( uint8_t )rand();
+    fec_encode( clean, clean_parity, BENCH_SIZE );
+    memcpy( noisy, clean, BENCH_SIZE );
+    memcpy( noisy_parity, clean_parity, BENCH_SIZE );
+    for( i = 0; i < BENCH_SIZE; ++i )
+    {
+        if( rand() & 1 )
+            noisy[i] ^= ( uint8_t )( 1 << ( rand() & 7 ) );
+        else
+            noisy_parity[i] ^= ( uint8_t )( 1 << ( rand() & 7 ) );
+    }
+
+    printf( "%d byte packets:\n", BENCH_SIZE );
+    printf( "  encode                %6.2f %s/byte\n", fec_time( 0, clean, NULL ), BENCH_UNIT );
+    printf( "  decode, no error      %6.2f %s/byte\n", fec_time( 1, clean, clean_parity ), BENCH_UNIT );
+    printf( "  decode, 1 bit a byte  %6.2f %s/byte\n", fec_time( 1, noisy, noisy_parity ), BENCH_UNIT );
+    return failures != 0;
+}
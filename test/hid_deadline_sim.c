@@ -0,0 +1,217 @@
+/**
+ * @file
+ *
+ * @brief Staleness of the HID report built ahead of each host poll
+ *
+ * hid_task.c is built with HID_REPORT_DEADLINE and SCHEDULER_PROFILE, and
+ * driven through its Start Of Frame and timer 1 compare handlers as the
+ * controller would. The host polls EP_HID_IN every interval frames, at a
+ * given time into the frame, its frames being slightly longer than 1 ms of
+ * timer 1. A poll takes the report waiting in the endpoint bank, or gets a
+ * NAK.
+ *
+ * hid_task records the staleness of each report taken, or 0xFFFF for a poll
+ * that found none. Once the interval and phase are learnt, no poll may be
+ * missed and the staleness must hold at HID_REPORT_MARGIN plus
+ * HID_REPORT_LEAD. A report built in the frame of its poll counts as fresh.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+//_____  I N C L U D E S _______________________________________________________
+
+#include <stdio.h>
+#include "config.h"
+
+// The report deadline and its staleness profile, whatever config.h says
+#undef HID_REPORT_DEADLINE
+#define HID_REPORT_DEADLINE     true
+#undef SCHEDULER_PROFILE
+#define SCHEDULER_PROFILE       true
+#ifndef SCHEDULER_PROFILE_FIRST_USER
+#define SCHEDULER_PROFILE_FIRST_USER 0
+void scheduler_profile_record( uint8_t profile, uint16_t ticks );
+#endif
+
+#include "../hid_task.c"
+
+//_____ M A C R O S ____________________________________________________________
+
+/// Frames per run
+#define SIM_FRAMES              3000
+/// Frames left to learn the interval and phase of the polls
+#define SIM_LEARN               ( 3 * EP_INTERVAL_1 )
+/// Timer 1 ticks per host frame, times 50: 1000.02 us
+#define SIM_FRAME_X50           50001L
+/// Timer 1 ticks lost rounding the host frames down
+#define SIM_ROUNDING            1
+/// Endpoint selected when the interrupts come
+#define SIM_OTHER_ENDPOINT      3
+
+//_____ V A R I A B L E S ______________________________________________________
+
+uint8_t usb_configuration_nb = 1;
+
+/// A report is waiting in the endpoint bank
+static bool bank_full;
+
+/// Current frame
+static long frame;
+
+/// Polls of the run, after SIM_LEARN
+static unsigned polls;
+static unsigned missed;
+static unsigned long staleness_total;
+static uint16_t staleness_max;
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+void snap_rx_usb( uint8_t c )
+{
+    ( void )c;
+}
+
+void scheduler_profile_record( uint8_t profile, uint16_t ticks )
+{
+    if( ( HID_PROFILE_STALENESS != profile ) || ( frame < SIM_LEARN ) )
+        return;
+
+    ++polls;
+    if( 0xFFFF == ticks )
+    {
+        ++missed;
+        return;
+    }
+    staleness_total += ticks;
+    if( ticks > staleness_max )
+        staleness_max = ticks;
+}
+
+/**
+ * @brief Update the endpoint bank after the firmware ran
+ *
+ * Clearing FIFOCON fills the bank; RWAL tells whether the bank can be written.
+ */
+static void sim_endpoint( void )
+{
+    if( !( UEINTX & ( 1 << FIFOCON ) ) )
+        bank_full = true;
+    UEINTX = ( UEINTX & ~( 1 << RWAL ) ) | ( bank_full ? 0 : ( 1 << RWAL ) ) | ( 1 << FIFOCON );
+}
+
+/**
+ * @brief Poll of EP_HID_IN by the host
+ */
+static void sim_poll( void )
+{
+    if( bank_full )
+        bank_full = false;
+    else
+        UEINTX |= ( 1 << NAKINI );
+    sim_endpoint();
+}
+
+/**
+ * @brief Run the firmware against polls every interval frames
+ *
+ * @param interval  frames between two polls
+ * @param phase     frame of the first poll, below interval
+ * @param poll_at   time of the poll into its frame, us
+ *
+ * @return false if the endpoint selection was lost
+ */
+static bool sim_run( uint8_t interval, uint8_t phase, uint16_t poll_at )
+{
+    uint16_t t0;
+    uint16_t deadline;
+    bool polled;
+    bool armed;
+
+    cpt_sof = 0;
+    poll_frame = 0;
+    poll_interval = EP_INTERVAL_1;
+    report_frame = 0;
+    report_built = false;
+    report_due = false;
+    report_polled = false;
+    TIMSK1 = 0;
+    bank_full = false;
+    UEINTX = 0;
+    sim_endpoint();
+    polls = missed = 0;
+    staleness_total = 0;
+    staleness_max = 0;
+    hid_task_init();
+
+    for( frame = 0; frame < SIM_FRAMES; ++frame )
+    {
+        t0 = ( uint16_t )( frame * SIM_FRAME_X50 / 50 );
+        TCNT1 = t0;
+        UENUM = SIM_OTHER_ENDPOINT;
+        sof_action();
+        if( SIM_OTHER_ENDPOINT != UENUM )
+            return false;
+        hid_task();
+        sim_endpoint();
+
+        polled = ( frame % interval ) == phase;
+        armed = TIMSK1 & ( 1 << OCIE1A );
+        deadline = OCR1A - t0;
+        if( armed && ( deadline >= 1000 ) )
+            armed = false;
+
+        if( polled && !( armed && ( deadline <= poll_at ) ) )
+        {
+            sim_poll();
+            polled = false;
+        }
+        if( armed )
+        {
+            TCNT1 = t0 + deadline;
+            TIMER1_COMPA_vect();
+            hid_task();
+            sim_endpoint();
+        }
+        if( polled )
+            sim_poll();
+    }
+    return true;
+}
+
+int main( void )
+{
+    static const uint8_t intervals[] = { 1, 2, 4, 8, 10 };
+    static const uint16_t poll_ats[] = { 20, 500, 980 };
+    uint8_t i;
+    uint8_t k;
+    uint8_t phase;
+    int failed = 0;
+
+    printf( "margin %d us, lead %d us, %ld frames a run\n",
+            HID_REPORT_MARGIN, HID_REPORT_LEAD, ( long )SIM_FRAMES );
+    printf( "%8s %6s %8s %7s %7s %15s %14s\n",
+            "interval", "phase", "poll at", "polls", "missed", "mean staleness", "max staleness" );
+    for( i = 0; i < sizeof( intervals ); ++i )
+    {
+        for( k = 0; k < sizeof( poll_ats ) / sizeof( poll_ats[0] ); ++k )
+        {
+            phase = intervals[i] - 1;
+            if( !sim_run( intervals[i], phase, poll_ats[k] ) )
+            {
+                printf( "endpoint selection lost by the Start Of Frame interrupt\n" );
+                return 1;
+            }
+            printf( "%8d %6d %8d %7u %7u %12lu us %11u us\n", intervals[i], phase, poll_ats[k],
+                    polls, missed, polls > missed ? staleness_total / ( polls - missed ) : 0,
+                    staleness_max );
+            if( ( 0 == polls ) || ( 0 != missed ) ||
+                ( staleness_max > HID_REPORT_MARGIN + HID_REPORT_LEAD + SIM_ROUNDING ) )
+                failed = 1;
+        }
+    }
+    return failed;
+}
@@ -0,0 +1,45 @@
+/**
+ * @file
+ *
+ * @brief Host stand-in for the AT90USB1287 registers, see avr/io.h
+ *
+ * Also holds the scheduler events the interrupt handlers post to.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+//_____  I N C L U D E S _______________________________________________________
+
+#include <avr/io.h>
+
+//_____ V A R I A B L E S ______________________________________________________
+
+volatile uint8_t TCCR1A;
+volatile uint8_t TCCR1B;
+volatile uint8_t TIFR1;
+volatile uint8_t TIMSK1;
+volatile uint16_t TCNT1;
+volatile uint16_t OCR1A;
+volatile uint16_t OCR1B;
+
+volatile uint8_t DDRB;
+volatile uint8_t DDRD;
+volatile uint8_t DDRE;
+volatile uint8_t PORTB;
+volatile uint8_t PORTD;
+volatile uint8_t PORTE;
+volatile uint8_t PINB;
+volatile uint8_t PIND;
+volatile uint8_t PINE;
+
+volatile uint8_t UENUM;
+volatile uint8_t UEINTX;
+volatile uint8_t UEDATX;
+volatile uint8_t UEBCLX;
+volatile uint8_t UEIENX;
+
+volatile uint8_t scheduler_events;
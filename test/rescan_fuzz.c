@@ -0,0 +1,282 @@
+/**
+ * @file
+ *
+ * @brief Bytes lost per line error by the S.N.A.P. receiver
+ *
+ * Streams of packets are fed to the firmware receiver with one error each: a
+ * flipped bit, a dropped byte or an inserted byte, at a random place. The
+ * packets mix the error detection methods, ACK requests and packets for
+ * another node, and their data bytes often hold SYNC. Every packet for this
+ * node that is not delivered counts as lost; the packet hit by the error is
+ * expected to be, any other one was lost resynchronizing.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+//_____  I N C L U D E S _______________________________________________________
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+#include "hid_event.h"
+#include "snap.h"
+#include "snap_crc.h"
+#include "snap_fec.h"
+#include "snap_host.h"
+#include "snap_task.h"
+
+//_____ M A C R O S ____________________________________________________________
+
+#define FUZZ_TRIALS             20000
+/// Packets per stream
+#define FUZZ_PACKETS            8
+/// Largest packet: SYNC, header, 16 data bytes and the largest trailer
+#define FUZZ_PACKET_MAX         ( 1 + 11 + 16 + 11 + 16 )
+/// Address of the other node
+#define FUZZ_OTHER              0x42
+
+//_____ T Y P E S ______________________________________________________________
+
+enum fuzz_errors
+{
+    kFlip,
+    kDrop,
+    kInsert,
+    kErrorCount
+};
+
+struct fuzz_packet
+{
+    uint8_t raw[FUZZ_PACKET_MAX];
+    uint8_t size;
+    /// Packet for this node, to be delivered
+    bool ours;
+};
+
+//_____ V A R I A B L E S ______________________________________________________
+
+static const char *const error_names[kErrorCount] = { "flipped bit", "dropped byte", "inserted byte" };
+
+/// Error detection methods used, EDM_3TX aside since a copy of it is always
+/// lost to the error without losing the packet
+static const uint8_t edms[] = { EDM_NONE, EDM_CHKSUM8, EDM_CRC8, EDM_CRC16, EDM_CRC32, EDM_FEC };
+
+/// Packets delivered in this stream, bit n for packet n
+static unsigned delivered;
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+static void fuzz_deliver( const uint8_t *data, uint16_t length )
+{
+    if( ( length >= 2 ) && ( data[1] < FUZZ_PACKETS ) )
+        delivered |= 1 << data[1];
+}
+
+/**
+ * @brief Data byte, SYNC one time in four
+ */
+static uint8_t fuzz_data( void )
+{
+    return ( 0 == ( random() & 3 ) ) ? SYNC : ( uint8_t )random();
+}
+
+/**
+ * @brief Build a random packet
+ *
+ * @param p         packet
+ * @param number    packet number, in its second data byte
+ * @param ours      packet for this node
+ * @param edm       HDB1::EDM code
+ * @param ndb       HDB1::NDB code, 2 data bytes at least
+ */
+static void fuzz_packet( struct fuzz_packet *p, uint8_t number, bool ours, uint8_t edm, uint8_t ndb )
+{
+    union HDB2 hdb2;
+    uint16_t length = pgm_read_word( &snap_ndb_length[ndb] );
+    uint16_t protected;
+    uint32_t crc;
+    uint8_t n = 0;
+    uint8_t i;
+
+    p->ours = ours;
+    hdb2.raw = 0;
+    hdb2.fields.DAB = DAB_1;
+    hdb2.fields.SAB = SAB_1;
+    hdb2.fields.PFB = random() % 2;
+    hdb2.fields.ACK = ( 0 == ( random() & 3 ) ) ? ACK_REQ : ACK_NONE;
+
+    p->raw[n++] = SYNC;
+    p->raw[n++] = hdb2.raw;
+    p->raw[n++] = ( edm << 4 ) | ndb;
+    p->raw[n++] = p->ours ? SNAP_NODE_ADDRESS : FUZZ_OTHER;
+    p->raw[n++] = 0x7E;
+    if( hdb2.fields.PFB )
+        p->raw[n++] = 0;
+    p->raw[n++] = HID_EVENT_MSG;
+    p->raw[n++] = number;
+    for( i = 2; i < length; ++i )
+        p->raw[n++] = fuzz_data();
+
+    protected = n - 1;
+    if( EDM_FEC == edm )
+    {
+        for( i = 1; i <= protected; ++i )
+            p->raw[n++] = snap_fec_parity( p->raw[i] );
+    }
+    else
+    {
+        crc = snap_crc_init( edm );
+        for( i = 1; i <= protected; ++i )
+            crc = snap_crc_update( edm, crc, p->raw[i] );
+        crc = snap_crc_final( edm, crc );
+        for( i = pgm_read_byte( &snap_edm_length[edm] ); i--; )
+            p->raw[n++] = ( uint8_t )( crc >> ( 8 * i ) );
+    }
+    p->size = n;
+}
+
+/**
+ * @brief Build a random packet
+ */
+static void fuzz_random_packet( struct fuzz_packet *p, uint8_t number, bool ours )
+{
+    uint8_t edm = edms[random() % sizeof( edms )];
+    uint8_t ndb = NDB_2 + random() % ( NDB_16 - NDB_2 + 1 );
+
+    fuzz_packet( p, number, ours, edm, ndb );
+}
+
+/**
+ * @brief Feed a byte to the node and let it process it
+ */
+static void fuzz_feed( uint8_t c )
+{
+    uint8_t answer;
+
+    host_rx_put( c );
+    snap_task();
+    while( host_tx_get( &answer ) )
+        ;
+}
+
+/**
+ * @brief Packets found in the bytes of a rejected packet
+ *
+ * Packet 0 announces 16 data bytes but carries 2, so it swallows the short
+ * packets following it and fails its check. They are found again: packet 1
+ * by its checksum, then packet 2 without one, packet 3 for another node and
+ * packet 4, each as they would have been received on their own.
+ *
+ * @return true if packets 1, 2 and 4 are delivered
+ */
+static bool fuzz_swallowed( void )
+{
+    static const uint8_t edm[5] = { EDM_CRC16, EDM_CRC8, EDM_NONE, EDM_CRC8, EDM_CHKSUM8 };
+    struct fuzz_packet p;
+    uint8_t k;
+    uint8_t n;
+
+    snap_task_init();
+    delivered = 0;
+    for( k = 0; k < 5; ++k )
+    {
+        fuzz_packet( &p, k, 3 != k, edm[k], NDB_2 );
+        if( 0 == k )
+            p.raw[2] = ( EDM_CRC16 << 4 ) | NDB_16;
+        for( n = 0; n < p.size; ++n )
+            fuzz_feed( p.raw[n] );
+    }
+    for( n = 0; n < 16; ++n )
+        fuzz_feed( 0 );
+    return 0x16 == delivered;
+}
+
+int main( void )
+{
+    static struct fuzz_packet packets[FUZZ_PACKETS];
+    unsigned long lost_bytes[kErrorCount] = { 0 };
+    unsigned long lost_packets[kErrorCount] = { 0 };
+    unsigned long extra_packets[kErrorCount] = { 0 };
+    unsigned long trials[kErrorCount] = { 0 };
+    unsigned long stream_bytes = 0;
+    unsigned trial;
+    unsigned hit;
+    unsigned at;
+    unsigned k;
+    unsigned n;
+    unsigned e;
+    int failed = 0;
+
+    srandom( 1 );
+    host_deliver = fuzz_deliver;
+    if( !fuzz_swallowed() )
+    {
+        printf( "packets following a rejected packet: delivered %02X, expected 16\n", delivered );
+        failed = 1;
+    }
+
+    for( trial = 0; trial < FUZZ_TRIALS; ++trial )
+    {
+        snap_task_init();
+        delivered = 0;
+        // The first and last packets are for this node, and neither is hit
+        for( k = 0; k < FUZZ_PACKETS; ++k )
+        {
+            fuzz_random_packet( &packets[k], k, ( 0 == k ) || ( FUZZ_PACKETS - 1 == k ) || ( 0 != random() % 5 ) );
+            stream_bytes += packets[k].size;
+        }
+        hit = 1 + random() % ( FUZZ_PACKETS - 2 );
+        at = random() % packets[hit].size;
+        e = trial % kErrorCount;
+        ++trials[e];
+
+        for( k = 0; k < FUZZ_PACKETS; ++k )
+        {
+            for( n = 0; n < packets[k].size; ++n )
+            {
+                if( ( k == hit ) && ( n == at ) )
+                {
+                    if( kFlip == e )
+                    {
+                        fuzz_feed( packets[k].raw[n] ^ ( 1 << ( random() & 7 ) ) );
+                        continue;
+                    }
+                    if( kDrop == e )
+                        continue;
+                    fuzz_feed( ( uint8_t )random() );
+                }
+                fuzz_feed( packets[k].raw[n] );
+            }
+        }
+
+        if( !( delivered & 1 ) )
+            failed = 1;
+        for( k = 0; k < FUZZ_PACKETS; ++k )
+        {
+            if( packets[k].ours && !( delivered & ( 1 << k ) ) )
+            {
+                lost_bytes[e] += packets[k].size;
+                ++lost_packets[e];
+                if( k != hit )
+                    ++extra_packets[e];
+            }
+        }
+    }
+
+    printf( "%d streams of %d packets, %lu bytes on average, one error each\n",
+            FUZZ_TRIALS, FUZZ_PACKETS, stream_bytes / FUZZ_TRIALS );
+    printf( "%-14s %12s %14s %18s\n", "error", "bytes lost", "packets lost", "other packets lost" );
+    for( e = 0; e < kErrorCount; ++e )
+    {
+        printf( "%-14s %12.2f %14.3f %18.3f\n", error_names[e],
+                ( double )lost_bytes[e] / trials[e],
+                ( double )lost_packets[e] / trials[e],
+                ( double )extra_packets[e] / trials[e] );
+    }
+    return failed;
+}
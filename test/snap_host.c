@@ -0,0 +1,195 @@
+/**
+ * @file
+ *
+ * @brief Host stand-ins for the USART and the HID events under the S.N.A.P. task
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+//_____  I N C L U D E S _______________________________________________________
+
+#include <stddef.h>
+#include "config.h"
+#include "hid_event.h"
+#include "snap_host.h"
+#include "lib_mcu/usart/usart.h"
+
+//_____ M A C R O S ____________________________________________________________
+
+#define HOST_RX_MASK            ( USART_RX_BUFFER_SIZE - 1 )
+#define HOST_TX_MASK            ( USART_TX_BUFFER_SIZE - 1 )
+
+//_____ V A R I A B L E S ______________________________________________________
+
+void ( *host_deliver )( const uint8_t *data, uint16_t length );
+
+static uint8_t rx_buf[USART_RX_BUFFER_SIZE];
+static unsigned rx_head;
+static unsigned rx_tail;
+static uint32_t rx_overflows;
+static unsigned rx_high_water;
+
+static uint8_t tx_buf[USART_TX_BUFFER_SIZE];
+static unsigned tx_head;
+static unsigned tx_tail;
+static unsigned tx_pending;
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+/**
+ * @brief Empty both USART buffers
+ */
+void host_reset( void )
+{
+    rx_head = rx_tail = 0;
+    rx_overflows = rx_high_water = 0;
+    tx_head = tx_tail = tx_pending = 0;
+}
+
+/**
+ * @brief Receive a byte from the line, as the USART receive interrupt does
+ *
+ * @return false if the receive buffer was full and the byte was dropped
+ */
+bool host_rx_put( uint8_t c )
+{
+    unsigned used = ( rx_head - rx_tail ) & HOST_RX_MASK;
+
+    if( used == HOST_RX_MASK )
+    {
+        ++rx_overflows;
+        return false;
+    }
+    rx_buf[rx_head] = c;
+    rx_head = ( rx_head + 1 ) & HOST_RX_MASK;
+    if( used + 1 > rx_high_water )
+        rx_high_water = used + 1;
+    return true;
+}
+
+/**
+ * @brief Send the next committed byte on the line
+ *
+ * @return false if there is none
+ */
+bool host_tx_get( uint8_t *c )
+{
+    if( tx_tail == tx_head )
+        return false;
+    tx_tail = ( tx_tail + 1 ) & HOST_TX_MASK;
+    *c = tx_buf[tx_tail];
+    return true;
+}
+
+/**
+ * @brief Bytes committed and not sent yet
+ */
+uint16_t host_tx_used( void )
+{
+    return ( tx_head - tx_tail ) & HOST_TX_MASK;
+}
+
+void USART0_Init( unsigned int baudrate )
+{
+    ( void )baudrate;
+    host_reset();
+}
+
+void USART0_SetBaud( unsigned int baudrate )
+{
+    ( void )baudrate;
+}
+
+unsigned int USART0_BaudUbrr( unsigned char code )
+{
+    return code;
+}
+
+unsigned int USART0_RxPeek( const unsigned char **span )
+{
+    unsigned n = ( rx_head - rx_tail ) & HOST_RX_MASK;
+
+    if( n > USART_RX_BUFFER_SIZE - rx_tail )
+        n = USART_RX_BUFFER_SIZE - rx_tail;
+    *span = &rx_buf[rx_tail];
+    return n;
+}
+
+void USART0_RxCommit( unsigned int n )
+{
+    rx_tail = ( rx_tail + n ) & HOST_RX_MASK;
+}
+
+uint32_t USART0_RxOverflows( void )
+{
+    return rx_overflows;
+}
+
+unsigned int USART0_RxHighWater( void )
+{
+    return rx_high_water;
+}
+
+bool USART0_TxIdle( void )
+{
+    return tx_tail == tx_head;
+}
+
+bool USART0_TxReserve( unsigned char n )
+{
+    if( n > HOST_TX_MASK - ( ( tx_head - tx_tail ) & HOST_TX_MASK ) )
+        return false;
+    tx_pending = tx_head;
+    return true;
+}
+
+void USART0_TxPut( unsigned char txdata )
+{
+    tx_pending = ( tx_pending + 1 ) & HOST_TX_MASK;
+    tx_buf[tx_pending] = txdata;
+}
+
+void USART0_TxRepeat( unsigned char copies )
+{
+    unsigned n = ( tx_pending - tx_head ) & HOST_TX_MASK;
+    unsigned src;
+    unsigned i;
+
+    while( copies-- )
+    {
+        src = tx_head;
+        for( i = 0; i < n; ++i )
+        {
+            src = ( src + 1 ) & HOST_TX_MASK;
+            USART0_TxPut( tx_buf[src] );
+        }
+    }
+}
+
+void USART0_TxCommit( void )
+{
+    tx_head = tx_pending;
+}
+
+uint16_t hid_event_frame( void )
+{
+    return 0;
+}
+
+bool hid_event_receive( const uint8_t *data, uint16_t length )
+{
+    if( NULL != host_deliver )
+        host_deliver( data, length );
+    return true;
+}
+
+bool hid_event_receive_batch( const uint8_t *data, uint16_t length )
+{
+    ( void )data;
+    ( void )length;
+    return true;
+}
@@ -0,0 +1,31 @@
+/**
+ * @file
+ *
+ * @brief Host stand-ins for the USART and the HID events under the S.N.A.P. task
+ *
+ * The USART keeps its receive and transmit buffers as the firmware does; the
+ * simulations move bytes in and out of them at the line rate they model.
+ * Packets carrying HID events are handed to host_deliver instead.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+#ifndef _SNAP_HOST_H_
+#define _SNAP_HOST_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// Called for each HID_EVENT_MSG packet the node processes, NULL to ignore them
+extern void ( *host_deliver )( const uint8_t *data, uint16_t length );
+
+void host_reset( void );
+bool host_rx_put( uint8_t c );
+bool host_tx_get( uint8_t *c );
+uint16_t host_tx_used( void );
+
+#endif /* _SNAP_HOST_H_ */
@@ -0,0 +1,22 @@
+/**
+ * @file
+ *
+ * @brief Host stand-in for the avr-libc atomic blocks
+ *
+ * The host programs are single threaded: the block simply runs once.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+#ifndef _HOST_ATOMIC_H_
+#define _HOST_ATOMIC_H_
+
+#define ATOMIC_RESTORESTATE     0
+#define ATOMIC_FORCEON          0
+#define ATOMIC_BLOCK(type)      for( int atomic_once_ = 1; atomic_once_; atomic_once_ = ( type ) )
+
+#endif /* _HOST_ATOMIC_H_ */
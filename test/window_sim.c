@@ -0,0 +1,352 @@
+/**
+ * @file
+ *
+ * @brief Throughput of sliding window delivery against stop-and-wait
+ *
+ * A host sends numbered HID_EVENT_MSG packets to the S.N.A.P. task over a
+ * simulated full duplex USART link, first waiting for the answer to each
+ * packet, then keeping up to SNAP_WINDOW_SIZE sequenced packets in flight.
+ * The node side is the firmware code itself, on the host USART stand-in.
+ *
+ * Time advances one byte time per step. Each byte is corrupted with the
+ * probability given by the bit error rate, and reaches the other side after
+ * the latency of the host serial adapter. The goodput is the share of the
+ * line rate carrying data bytes of packets delivered for the first time.
+ *
+ * @author               Andrew Cooper
+ *
+ */
+
+/* Copyright (c) 2010 Andrew Cooper. All rights reserved.
+ */
+
+//_____  I N C L U D E S _______________________________________________________
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+#include "hid_event.h"
+#include "snap.h"
+#include "snap_crc.h"
+#include "snap_host.h"
+#include "snap_task.h"
+#include "snap_window.h"
+
+//_____ M A C R O S ____________________________________________________________
+
+/// Packets delivered per run
+#define SIM_PACKETS             2000
+/// Data bytes per packet, HDB1::NDB code
+#define SIM_NDB                 NDB_32
+#define SIM_DATA                32
+/// Bits per byte on the line: start, 8 data bits, USART_STOP_BITS stop bits
+#define SIM_BITS                ( 9 + USART_STOP_BITS )
+/// Latency of the host serial adapter each way, us
+#define SIM_LATENCY_US          1000
+/// Longest line delay, in byte times, the delay lines hold
+#define SIM_DELAY_MAX           1024
+/// Bytes of a packet: SYNC, HDB2, HDB1, DAB, SAB, PFB, data and CRC16
+#define SIM_PACKET_SIZE         ( 6 + SIM_DATA + 2 )
+/// Sequence numbers, see SNAP_SEQ_MASK
+#define SIM_SEQ                 ( SNAP_SEQ_MASK + 1 )
+/// Host address
+#define SIM_HOST                0x7E
+
+//_____ T Y P E S ______________________________________________________________
+
+/**
+ * @brief One direction of the link: bytes on their way, by arrival time
+ */
+struct line
+{
+    int16_t byte[SIM_DELAY_MAX];
+};
+
+/**
+ * @brief Host answer parser
+ */
+struct answer
+{
+    uint8_t raw[8];
+    uint8_t n;
+};
+
+//_____ V A R I A B L E S ______________________________________________________
+
+/// Bytes corrupted out of 2^31
+static long error_threshold;
+
+/// Next packet number the node delivers for the first time
+static unsigned delivered;
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+/**
+ * @brief Random corruption of one byte on the line
+ */
+static uint8_t sim_line_byte( uint8_t c )
+{
+    if( random() < error_threshold )
+        c ^= ( uint8_t )( 1 << ( random() & 7 ) );
+    return c;
+}
+
+/**
+ * @brief Count the packets delivered for the first time, in packet number order
+ */
+static void sim_deliver( const uint8_t *data, uint16_t length )
+{
+    unsigned number = ( data[1] << 8 ) | data[2];
+
+    if( ( length == SIM_DATA ) && ( number == delivered ) )
+        ++delivered;
+}
+
+/**
+ * @brief Build a packet from the host
+ *
+ * @param p         packet bytes, SIM_PACKET_SIZE
+ * @param number    packet number
+ * @param flag      protocol specific flag byte
+ */
+static void sim_packet( uint8_t *p, unsigned number, uint8_t flag )
+{
+    uint32_t crc = snap_crc_init( EDM_CRC16 );
+    uint8_t i;
+
+    p[0] = SYNC;
+    p[1] = ( DAB_1 << 6 ) | ( SAB_1 << 4 ) | ( PFB_1 << 2 ) | ACK_REQ;
+    p[2] = ( EDM_CRC16 << 4 ) | SIM_NDB;
+    p[3] = SNAP_NODE_ADDRESS;
+    p[4] = SIM_HOST;
+    p[5] = flag;
+    memset( p + 6, 0, SIM_DATA );
+    p[6] = HID_EVENT_MSG;
+    p[7] = ( uint8_t )( number >> 8 );
+    p[8] = ( uint8_t )number;
+    for( i = 1; i < SIM_PACKET_SIZE - 2; ++i )
+        crc = snap_crc_update( EDM_CRC16, crc, p[i] );
+    p[i++] = ( uint8_t )( crc >> 8 );
+    p[i] = ( uint8_t )crc;
+}
+
+/**
+ * @brief Feed one byte to the host answer parser
+ *
+ * @param a     parser
+ * @param c     received byte
+ * @param ack   set to ACK_RESP or NAK_RESP
+ * @param seq   set to the flag byte, 0 if none
+ *
+ * @return true once a valid answer is complete
+ */
+static bool sim_answer( struct answer *a, uint8_t c, uint8_t *ack, uint8_t *seq )
+{
+    union HDB2 hdb2;
+    uint8_t size;
+    uint32_t crc;
+    uint8_t i;
+
+    if( 0 == a->n )
+    {
+        if( SYNC == c )
+            a->raw[a->n++] = c;
+        return false;
+    }
+    a->raw[a->n++] = c;
+    if( a->n < 2 )
+        return false;
+
+    hdb2.raw = a->raw[1];
+    size = 5 + hdb2.fields.PFB + 2;
+    if( ( hdb2.fields.DAB != DAB_1 ) || ( hdb2.fields.SAB != SAB_1 ) || ( hdb2.fields.PFB > PFB_1 ) )
+    {
+        a->n = 0;
+        return false;
+    }
+    if( a->n < size )
+        return false;
+
+    a->n = 0;
+    crc = snap_crc_init( EDM_CRC16 );
+    for( i = 1; i < size - 2; ++i )
+        crc = snap_crc_update( EDM_CRC16, crc, a->raw[i] );
+    if( ( a->raw[size - 2] != ( uint8_t )( crc >> 8 ) ) ||
+        ( a->raw[size - 1] != ( uint8_t )crc ) ||
+        ( a->raw[3] != SIM_HOST ) )
+        return false;
+
+    *ack = hdb2.fields.ACK;
+    *seq = ( PFB_1 == hdb2.fields.PFB ) ? a->raw[5] : 0;
+    return true;
+}
+
+/**
+ * @brief Deliver SIM_PACKETS packets
+ *
+ * @param baud      line rate, bit/s
+ * @param window    false for stop-and-wait
+ *
+ * @return goodput, share of the line rate
+ */
+static double sim_run( long baud, bool window )
+{
+    static struct line down;
+    static struct line up;
+    static uint8_t frame[SIM_SEQ][SIM_PACKET_SIZE];
+    static long sent_at[SIM_SEQ];
+    struct answer a;
+    long delay = ( long )SIM_LATENCY_US * baud / SIM_BITS / 1000000 + 1;
+    long timeout = 2 * delay + 4 * SIM_PACKET_SIZE;
+    long t;
+    long last_progress = 0;
+    unsigned base = 0;          // oldest packet not acknowledged
+    unsigned next = 0;          // next packet sent for the first time
+    unsigned limit = window ? SNAP_WINDOW_SIZE : 1;
+    const uint8_t *out = NULL;  // packet being sent
+    uint8_t out_n = 0;
+    uint8_t c;
+    uint8_t ack;
+    uint8_t seq;
+    int16_t in;
+    unsigned n;
+
+    if( delay >= SIM_DELAY_MAX )
+        delay = SIM_DELAY_MAX - 1;
+
+    host_deliver = sim_deliver;
+    snap_task_init();
+    delivered = 0;
+    memset( &a, 0, sizeof( a ) );
+    for( n = 0; n < SIM_DELAY_MAX; ++n )
+    {
+        down.byte[n] = -1;
+        up.byte[n] = -1;
+    }
+
+    for( t = 0; delivered < SIM_PACKETS; ++t )
+    {
+        // Host: pick the packet to send once the previous one has left
+        if( 0 == out_n )
+        {
+            if( t - last_progress > timeout )
+            {
+                // Nothing heard: send the oldest packet again
+                out = frame[base % SIM_SEQ];
+                out_n = SIM_PACKET_SIZE;
+                sent_at[base % SIM_SEQ] = t;
+                last_progress = t;
+            }
+            else if( ( next - base < limit ) && ( next < SIM_PACKETS ) )
+            {
+                sim_packet( frame[next % SIM_SEQ], next,
+                            window ? ( uint8_t )( SNAP_SEQ_WINDOW | ( next % SIM_SEQ ) |
+                                                  ( ( 0 == next ) ? SNAP_SEQ_RESTART : 0 ) )
+                                   : 0 );
+                out = frame[next % SIM_SEQ];
+                out_n = SIM_PACKET_SIZE;
+                sent_at[next % SIM_SEQ] = t;
+                if( next == base )
+                    last_progress = t;
+                ++next;
+            }
+        }
+        down.byte[( t + delay ) % SIM_DELAY_MAX] = out_n ? sim_line_byte( *out ) : -1;
+        if( out_n )
+        {
+            ++out;
+            --out_n;
+        }
+
+        // Node: receive, process, send
+        in = down.byte[t % SIM_DELAY_MAX];
+        down.byte[t % SIM_DELAY_MAX] = -1;
+        if( in >= 0 )
+        {
+            host_rx_put( ( uint8_t )in );
+            snap_task();
+        }
+        up.byte[( t + delay ) % SIM_DELAY_MAX] = host_tx_get( &c ) ? sim_line_byte( c ) : -1;
+
+        // Host: answers
+        in = up.byte[t % SIM_DELAY_MAX];
+        up.byte[t % SIM_DELAY_MAX] = -1;
+        if( ( in < 0 ) || !sim_answer( &a, ( uint8_t )in, &ack, &seq ) )
+            continue;
+
+        if( !window )
+        {
+            if( ACK_RESP == ack )
+            {
+                ++base;
+                last_progress = t;
+            }
+            else
+            {
+                // Send it again right away
+                next = base;
+                last_progress = t;
+            }
+            continue;
+        }
+
+        if( !( seq & SNAP_SEQ_WINDOW ) )
+            continue;
+        seq &= SNAP_SEQ_MASK;
+        n = ( seq - base ) % SIM_SEQ;
+        if( ACK_RESP == ack )
+        {
+            // Cumulative: every packet up to seq arrived
+            if( n < next - base )
+            {
+                base += n + 1;
+                last_progress = t;
+            }
+        }
+        else if( ( 0 == n ) && ( base < next ) && ( t - sent_at[base % SIM_SEQ] > 2 * delay ) )
+        {
+            // The oldest packet is missing, unless already sent again since
+            if( 0 == out_n )
+            {
+                out = frame[base % SIM_SEQ];
+                out_n = SIM_PACKET_SIZE;
+                sent_at[base % SIM_SEQ] = t;
+            }
+        }
+    }
+
+    return ( double )SIM_PACKETS * SIM_DATA / t;
+}
+
+int main( void )
+{
+    static const long bauds[] = { 9600, 57600, 250000, 1000000 };
+    static const double bers[] = { 0, 1e-5, 1e-4, 1e-3 };
+    unsigned b;
+    unsigned e;
+    double stop;
+    double win;
+    int failed = 0;
+
+    printf( "%d data bytes per packet, window %d, adapter latency %d us each way\n",
+            SIM_DATA, SNAP_WINDOW_SIZE, SIM_LATENCY_US );
+    printf( "%8s %8s %14s %14s %7s\n", "baud", "BER", "stop-and-wait", "window", "gain" );
+    for( b = 0; b < sizeof( bauds ) / sizeof( bauds[0] ); ++b )
+    {
+        for( e = 0; e < sizeof( bers ) / sizeof( bers[0] ); ++e )
+        {
+            error_threshold = ( long )( ( 1.0 - pow( 1.0 - bers[e], 8 ) ) * 2147483648.0 );
+            srandom( 1 );
+            stop = sim_run( bauds[b], false );
+            srandom( 1 );
+            win = sim_run( bauds[b], true );
+            printf( "%8ld %8.0e %13.1f%% %13.1f%% %6.2fx\n", bauds[b], bers[e],
+                    100 * stop, 100 * win, win / stop );
+            if( win < stop )
+                failed = 1;
+        }
+    }
+    return failed;
+}
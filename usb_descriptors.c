@@ -176,6 +176,9 @@ PROGMEM S_usb_hid_report_descriptor usb_hid_report_descriptor =
         REPORT_ITEM_SHORT1( GLOBAL_USAGE_PAGE, USAGE_PAGE_GENERIC_DESKTOP ),
         REPORT_ITEM_SHORT1( LOCAL_USAGE, GENERIC_DESKTOP_GAMEPAD ),
         REPORT_ITEM_SHORT1( MAIN_COLLECTION, COLLECTION_APPLICATION ),
+#if (SNAP_USB_TUNNEL == true)
+        REPORT_ITEM_SHORT1( GLOBAL_REPORT_ID, REPORT_ID_GUITAR ),
+#endif
         REPORT_ITEM_SHORT1( GLOBAL_LOGICAL_MIN, 0 ),
         REPORT_ITEM_SHORT1( GLOBAL_LOGICAL_MAX, 1 ),
         REPORT_ITEM_SHORT1( GLOBAL_PHYSICAL_MIN, 0 ),
@@ -292,7 +295,39 @@ PROGMEM S_usb_hid_report_descriptor usb_hid_report_descriptor =
             INPUT_PREFERRED_STATE |
             INPUT_NO_NULL_POSITION |
             INPUT_BITFIELD ),
+        REPORT_ITEM_SHORT0( MAIN_ENDCOLLECTION ),
+#if (SNAP_USB_TUNNEL == true)
+        // S.N.A.P. tunnel, a collection of its own for the host to open
+        REPORT_ITEM_SHORT2( GLOBAL_USAGE_PAGE, 65280 ),
+        REPORT_ITEM_SHORT1( LOCAL_USAGE, 0x01 ),
+        REPORT_ITEM_SHORT1( MAIN_COLLECTION, COLLECTION_APPLICATION ),
+        REPORT_ITEM_SHORT1( GLOBAL_REPORT_ID, REPORT_ID_SNAP ),
+        REPORT_ITEM_SHORT1( GLOBAL_LOGICAL_MIN, 0 ),
+        REPORT_ITEM_SHORT2( GLOBAL_LOGICAL_MAX, 255 ),
+        REPORT_ITEM_SHORT2( GLOBAL_PHYSICAL_MAX, 255 ),
+        REPORT_ITEM_SHORT1( GLOBAL_REPORT_SIZE, 8 ),
+        REPORT_ITEM_SHORT1( GLOBAL_REPORT_COUNT, SNAP_REPORT_SIZE ),
+        REPORT_ITEM_SHORT1( LOCAL_USAGE, 0x02 ),
+        REPORT_ITEM_SHORT1( MAIN_INPUT, INPUT_DATA |
+            INPUT_VARIABLE |
+            INPUT_ABSOLUTE |
+            INPUT_NO_WRAP |
+            INPUT_LINEAR |
+            INPUT_PREFERRED_STATE |
+            INPUT_NO_NULL_POSITION |
+            INPUT_BITFIELD ),
+        REPORT_ITEM_SHORT1( LOCAL_USAGE, 0x03 ),
+        REPORT_ITEM_SHORT1( MAIN_OUTPUT, OUTPUT_DATA |
+            OUTPUT_VARIABLE |
+            OUTPUT_ABSOLUTE |
+            OUTPUT_NO_WRAP |
+            OUTPUT_LINEAR |
+            OUTPUT_PREFERRED_STATE |
+            OUTPUT_NO_NULL_POSITION |
+            OUTPUT_NONVOLATILE |
+            OUTPUT_BITFIELD ),
         REPORT_ITEM_SHORT0( MAIN_ENDCOLLECTION )
+#endif
     }
     };
 
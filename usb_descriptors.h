@@ -106,7 +106,18 @@
 #define EP_ATTRIBUTES_2     0x03          // BULK = 0x02, INTERUPT = 0x03
 #define EP_SIZE_2           64
 #define EP_INTERVAL_2       1 //interrupt pooling from host
+
+#if (SNAP_USB_TUNNEL == true)
+/// Report ID of the guitar input, output and feature reports
+#define REPORT_ID_GUITAR      1
+/// Report ID of the S.N.A.P. tunnel, input and output, see hid_report_tunnel()
+#define REPORT_ID_SNAP        2
+/// Bytes following the report ID in a S.N.A.P. tunnel report
+#define SNAP_REPORT_SIZE      63
+#define SIZE_OF_REPORT        169
+#else
 #define SIZE_OF_REPORT        137
+#endif
 
 #define DEVICE_STATUS         USB_DEVICE_STATUS_BUS_POWERED
 
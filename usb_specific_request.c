@@ -46,16 +46,39 @@
 
 //_____ I N C L U D E S ________________________________________________________
 
+#include <util/atomic.h>
 #include "config.h"
 #include "conf_usb.h"
 #include "lib_mcu/usb/usb_drv.h"
 #include "usb_descriptors.h"
 #include "modules/usb/device_chap9/usb_standard_request.h"
 #include "usb_specific_request.h"
+#include "hid_task.h"
+#include "snap_task.h"
+#include "snap_usb.h"
+#include "modules/scheduler/scheduler.h"
 #if ((USB_DEVICE_SN_USE==true) && (USE_DEVICE_SN_UNIQUE==true))
 #include "lib_mcu/flash/flash_drv.h"
 #endif
 
+//_____ M A C R O S ____________________________________________________________
+
+/// Size of the feature report
+#define FEATURE_REPORT_SIZE     8
+
+/// First byte of a feature report selecting the counter returned next
+#define STAT_FEATURE_SELECT     0xC5
+/// First byte of a feature report clearing the counters
+#define STAT_FEATURE_CLEAR      0xCC
+
+#if SCHEDULER_PROFILING == true
+/// Values returned by the feature report: the counters, then the scheduler profiles
+#define STAT_FEATURE_VALUES     ( kStatCount + SCHEDULER_PROFILE_COUNT )
+#else
+/// Values returned by the feature report
+#define STAT_FEATURE_VALUES     kStatCount
+#endif
+
 //_____ D E F I N I T I O N ____________________________________________________
 
 extern PGM_VOID_P pbuffer;
@@ -65,6 +88,9 @@ uint8_t jump_bootloader = 0;
 
 uint8_t g_u8_report_rate = 0;
 
+/// Value returned by the next feature report, below STAT_FEATURE_VALUES
+static uint8_t stat_index = 0;
+
 //_____ D E C L A R A T I O N __________________________________________________
 
 void hid_get_report_descriptor( void );
@@ -73,6 +99,11 @@ void usb_hid_set_idle( uint8_t u8_report_id, uint8_t u8_duration );
 void usb_hid_get_idle( uint8_t u8_report_id );
 void hid_get_hid_descriptor( void );
 void usb_hid_set_report_feature( void );
+void usb_hid_get_report_feature( void );
+void usb_hid_get_report_input( void );
+#if (SNAP_USB_TUNNEL == true)
+void usb_hid_get_report_tunnel( void );
+#endif
 
 /**
  * @brief Check the specific request and if known then process it
@@ -156,7 +187,21 @@ bool usb_user_read_request( uint8_t type, uint8_t request )
         switch( request )
             {
         case SETUP_HID_GET_REPORT :
-            // TODO
+            if( REPORT_TYPE_FEATURE == wValue_msb )
+            {
+                usb_hid_get_report_feature();
+                return true;
+            }
+            if( REPORT_TYPE_INPUT == wValue_msb )
+            {
+#if (SNAP_USB_TUNNEL == true)
+                if( REPORT_ID_SNAP == wValue_lsb )
+                    usb_hid_get_report_tunnel();
+                else
+#endif
+                    usb_hid_get_report_input();
+                return true;
+            }
             break;
         case SETUP_HID_GET_IDLE :
             usb_hid_get_idle( wValue_lsb );
@@ -351,6 +396,9 @@ void hid_get_report_descriptor( void )
 
 /**
  * @brief Manage HID set report request.
+ *
+ * With SNAP_USB_TUNNEL, REPORT_ID_SNAP reports carry S.N.A.P. bytes as they
+ * do through EP_HID_OUT, see hid_report_tunnel().
  */
 void usb_hid_set_report_ouput( void )
 {
@@ -359,6 +407,10 @@ void usb_hid_set_report_ouput( void )
 
     while( !Is_usb_receive_out() )
         ;
+#if (SNAP_USB_TUNNEL == true)
+    if( REPORT_ID_SNAP == Usb_read_byte() )
+        hid_report_tunnel();
+#endif
     Usb_ack_receive_out();
     Usb_send_control_in();
 }
@@ -420,8 +472,18 @@ void usb_hid_get_idle( uint8_t u8_report_id )
     Usb_ack_receive_out();
 }
 
+/**
+ * @brief Manage HID set feature report request.
+ *
+ * - 55 AA 55 AA: jump to the bootloader
+ * - STAT_FEATURE_SELECT index: return counter index with the next feature report
+ * - STAT_FEATURE_CLEAR: clear the counters and the scheduler profiles
+ *
+ * With SNAP_USB_TUNNEL, these bytes follow the REPORT_ID_GUITAR report ID.
+ */
 void usb_hid_set_report_feature( void )
 {
+    uint8_t c;
 
     Usb_ack_receive_setup();
     Usb_send_control_in();
@@ -429,7 +491,24 @@ void usb_hid_set_report_feature( void )
     while( !Is_usb_receive_out() )
         ;
 
-    if( Usb_read_byte() == 0x55 )
+#if (SNAP_USB_TUNNEL == true)
+    Usb_read_byte(); // Report ID
+#endif
+    c = Usb_read_byte();
+    if( STAT_FEATURE_SELECT == c )
+    {
+        stat_index = Usb_read_byte();
+        if( stat_index >= STAT_FEATURE_VALUES )
+            stat_index = 0;
+    }
+    else if( STAT_FEATURE_CLEAR == c )
+    {
+        snap_stat_clear();
+#if SCHEDULER_PROFILING == true
+        scheduler_profile_clear();
+#endif
+    }
+    else if( c == 0x55 )
         if( Usb_read_byte() == 0xAA )
             if( Usb_read_byte() == 0x55 )
                 if( Usb_read_byte() == 0xAA )
@@ -442,6 +521,162 @@ void usb_hid_set_report_feature( void )
         ;
 }
 
+/**
+ * @brief Manage HID get feature report request.
+ *
+ * Each report carries one value, the next one being returned by the next
+ * report, so that a host polling the report walks through all of them. The
+ * counters of enum snap_stat come first, followed by the task profiles with
+ * SCHEDULER_PROFILE and the wake-up latency with SCHEDULER_SLEEP (see
+ * scheduler_profile_value()):
+ *
+ * - byte 0: value index
+ * - byte 1: number of values (STAT_FEATURE_VALUES)
+ * - bytes 2-5: value, LSB first
+ * - bytes 6-7: 0
+ *
+ * With SNAP_USB_TUNNEL, these bytes follow the REPORT_ID_GUITAR report ID.
+ */
+void usb_hid_get_report_feature( void )
+{
+    uint16_t wLength;
+    uint16_t wInterface;
+    uint8_t buf[FEATURE_REPORT_SIZE];
+    uint32_t value;
+    uint8_t i;
+
+    BYTEn( wInterface, 0 ) = Usb_read_byte();
+    BYTEn( wInterface, 1 ) = Usb_read_byte();
+    BYTEn( wLength, 0 ) = Usb_read_byte();
+    BYTEn( wLength, 1 ) = Usb_read_byte();
+    Usb_ack_receive_setup();
+
+#if SCHEDULER_PROFILING == true
+    if( stat_index >= kStatCount )
+        value = scheduler_profile_value( stat_index - kStatCount );
+    else
+#endif
+        value = snap_stat( stat_index );
+    buf[0] = stat_index;
+    buf[1] = STAT_FEATURE_VALUES;
+    for( i = 2; i < 6; ++i )
+    {
+        buf[i] = ( uint8_t )value;
+        value >>= 8;
+    }
+    buf[6] = 0;
+    buf[7] = 0;
+    if( ++stat_index >= STAT_FEATURE_VALUES )
+        stat_index = 0;
+
+#if (SNAP_USB_TUNNEL == true)
+    if( wLength > 0 )
+    {
+        Usb_write_byte( REPORT_ID_GUITAR );
+        --wLength;
+    }
+#endif
+    if( wLength > FEATURE_REPORT_SIZE )
+        wLength = FEATURE_REPORT_SIZE;
+    for( i = 0; i < wLength; ++i )
+    {
+        Usb_write_byte( buf[i] );
+    }
+    Usb_send_control_in();
+
+    while( !Is_usb_receive_out() )
+        ;
+    Usb_ack_receive_out();
+}
+
+/**
+ * @brief Manage HID get input report request: the guitar report
+ *
+ * The report last built is returned, as sent through EP_HID_IN, its report ID
+ * first with SNAP_USB_TUNNEL.
+ */
+void usb_hid_get_report_input( void )
+{
+    uint16_t wLength;
+    uint16_t wInterface;
+    uint8_t *report_p = ( uint8_t* ) &report;
+    uint8_t i;
+
+    BYTEn( wInterface, 0 ) = Usb_read_byte();
+    BYTEn( wInterface, 1 ) = Usb_read_byte();
+    BYTEn( wLength, 0 ) = Usb_read_byte();
+    BYTEn( wLength, 1 ) = Usb_read_byte();
+    Usb_ack_receive_setup();
+
+#if (SNAP_USB_TUNNEL == true)
+    if( wLength > 0 )
+    {
+        Usb_write_byte( REPORT_ID_GUITAR );
+        --wLength;
+    }
+#endif
+    if( wLength > sizeof( report ) )
+        wLength = sizeof( report );
+    ATOMIC_BLOCK( ATOMIC_RESTORESTATE )
+    {
+        for( i = 0; i < wLength; ++i )
+        {
+            Usb_write_byte( report_p[i] );
+        }
+    }
+    Usb_send_control_in();
+
+    while( !Is_usb_receive_out() )
+        ;
+    Usb_ack_receive_out();
+}
+
+#if (SNAP_USB_TUNNEL == true)
+/**
+ * @brief Manage HID get input report request: S.N.A.P. answers
+ *
+ * Answers to the packets tunnelled through USB are read back by the host with
+ * REPORT_ID_SNAP input reports, laid out as the tunnel output reports (see
+ * hid_report_tunnel()): after the report ID, the number of S.N.A.P. bytes
+ * following it, then padding up to SNAP_REPORT_SIZE bytes.
+ */
+void usb_hid_get_report_tunnel( void )
+{
+    uint16_t wLength;
+    uint16_t wInterface;
+    uint8_t buf[SNAP_REPORT_SIZE - 1];
+    uint8_t n;
+    uint8_t i;
+
+    BYTEn( wInterface, 0 ) = Usb_read_byte();
+    BYTEn( wInterface, 1 ) = Usb_read_byte();
+    BYTEn( wLength, 0 ) = Usb_read_byte();
+    BYTEn( wLength, 1 ) = Usb_read_byte();
+    Usb_ack_receive_setup();
+
+    if( wLength > 1 + SNAP_REPORT_SIZE )
+        wLength = 1 + SNAP_REPORT_SIZE;
+    n = ( wLength > 2 ) ? snap_usb_tx_read( buf, wLength - 2 ) : 0;
+    if( wLength > 0 )
+    {
+        Usb_write_byte( REPORT_ID_SNAP );
+    }
+    if( wLength > 1 )
+    {
+        Usb_write_byte( n );
+    }
+    for( i = 2; i < wLength; ++i )
+    {
+        Usb_write_byte( ( i - 2 < n ) ? buf[i - 2] : 0 );
+    }
+    Usb_send_control_in();
+
+    while( !Is_usb_receive_out() )
+        ;
+    Usb_ack_receive_out();
+}
+#endif
+
 /**
  * @brief Manage HID get hid descriptor request.
  */